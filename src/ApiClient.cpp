@@ -0,0 +1,196 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ApiClient.h"
+
+#include "Config.h"
+
+// For SHOW_HTTP_HEADERS
+#include "Options.h"
+
+using namespace ECG ;
+
+// Note: functions in this file should appear in the same order
+// as their declerations appear in their header.
+
+String ApiClient::buildRequest(uint8_t endpoint) {
+
+    // The last request asks the server to close the connection once it has answered
+    bool last = endpoint == _endpointCount - 1 ;
+
+    // If enabled, ask for CBOR but accept JSON from servers that do not support it
+    return "GET " + _path + _endpoints[endpoint] + " HTTP/1.1\r\n" +
+           "Host: " + _host + "\r\n" +
+           ( Config::requestBinaryFormat ? "Accept: application/cbor, application/json;q=0.9\r\n" : "" ) +
+           ( last ? "Connection: close\r\n\r\n" : "Connection: keep-alive\r\n\r\n" ) ;
+}
+
+ApiClient::ApiClient(const String& host, uint16_t port, const String& path,
+                     const String* endpoints, uint8_t endpointCount, bool pipelining) {
+    _host = host ;
+    _port = port ;
+    _path = path ;
+    _endpoints = endpoints ;
+    _endpointCount = endpointCount ;
+    _pipelining = pipelining ;
+    _fetched = 0 ;
+    _result = HTTP_OK ;
+    _phase = PHASE_CONNECT ;
+}
+
+bool ApiClient::fetch(ResponseHandler handler) {
+
+    // Every step of every request below is bounded by the time limits in Config.h,
+    // and the fetch as a whole by requestTimeout for each endpoint
+    HttpReader reader(_client) ;
+    HttpResponse response ;
+    reader.start(Config::requestTimeout * _endpointCount) ;
+
+    // Endpoints are requested in the order they are listed.
+    // _fetched is the first endpoint whose response has not been read yet
+    _fetched = 0 ;
+    _result = HTTP_OK ;
+    _phase = PHASE_CONNECT ;
+    bool connected = false ;
+    bool allSucceeded = true ;
+
+    while (_fetched < _endpointCount) {
+
+        // First, we must establish a connection to the API
+        // This is repeated if the server closes the connection before every endpoint has been fetched
+        if (!connected) {
+            Serial.printf("Connecting to %s on port %d... \n", _host.c_str(), _port) ;
+
+            if ( !reader.connect(_host, _port) ) {
+                Serial.printf("Connection failed!\n") ;
+                _result = reader.result() ;
+                _phase = PHASE_CONNECT ;
+                allSucceeded = false ;
+                break ;
+            }
+            connected = true ;
+        }
+
+        // Next, we send the HTTP get requests
+        // With pipelining, every remaining request is sent at once, otherwise just the next one
+        uint8_t roundEnd = _pipelining ? _endpointCount : _fetched + 1 ;
+        uint8_t roundSize = roundEnd - _fetched ;
+        bool sendFailed = false ;
+        for (uint8_t i = _fetched; i < roundEnd; i++) {
+            String getRequest = buildRequest(i) ;
+
+            // Display request being sent for debug purposes if the option has been set in Options.h
+            if (SHOW_HTTP_HEADERS) {
+                Serial.printf("Sending the following request:\n%s\n", getRequest.c_str() ) ;
+            }
+
+            if (!reader.send(getRequest)) {
+                sendFailed = true ;
+                break ;
+            }
+        }
+
+        // Case: the request could not be sent
+        if (sendFailed) {
+            Serial.printf("Sending the request for %s failed after %u ms (%s).\n",
+                _endpoints[_fetched].c_str(), reader.elapsed(),
+                reader.result() == HTTP_TIMEOUT ? "timed out" : "connection closed") ;
+            _result = reader.result() ;
+            _phase = PHASE_CONNECT ;
+            allSucceeded = false ;
+            break ;
+        }
+
+        // The server answers in the order the requests were sent, so each response
+        // goes to the endpoint after the one before it
+        bool readFailed = false ;
+        bool keepAlive = true ;
+        while (_fetched < roundEnd) {
+            if (!reader.readResponse(response)) {
+                readFailed = true ;
+                break ;
+            }
+
+            if (!handler(_fetched, response)) {
+                allSucceeded = false ;
+            }
+            _fetched++ ;
+
+            // The server will not read any more requests on this connection
+            if (!response.keepAlive) {
+                keepAlive = false ;
+                break ;
+            }
+        }
+
+        // Case: the server closed the connection on pipelined requests, whether or not it answered
+        // any of them first. It probably does not support pipelining, so go back to one request at a time.
+        // Timeouts and malformed responses say nothing about pipelining, so they are handled as normal failures below
+        bool closedEarly = !keepAlive || ( readFailed && reader.result() == HTTP_CLOSED ) ;
+        if (_pipelining && roundSize > 1 && _fetched < roundEnd && closedEarly) {
+            Serial.printf("Server stopped answering pipelined requests. Switching to sequential requests.\n") ;
+            _pipelining = false ;
+            _client.stop() ;
+            connected = false ;
+            continue ;
+        }
+
+        // Case: The response could not be read in full
+        if (readFailed) {
+            Serial.printf("Reading the response for %s failed during the %s phase after %u ms (%s).\n",
+                _endpoints[_fetched].c_str(), HttpReader::phaseName(reader.phase()), reader.elapsed(),
+                reader.result() == HTTP_TIMEOUT ? "timed out" :
+                reader.result() == HTTP_CLOSED ? "connection closed" : "malformed response") ;
+            _result = reader.result() ;
+            _phase = reader.phase() ;
+            allSucceeded = false ;
+            break ;
+        }
+
+        // Case: the server closed the connection as it said it would. Reconnect for any remaining endpoints
+        if (!keepAlive) {
+            _client.stop() ;
+            connected = false ;
+        }
+    }
+
+    // Close the connection whatever happened
+    _client.stop() ;
+
+    Serial.printf("Fetched %d of %d endpoints (%s).\n", _fetched, _endpointCount,
+        _pipelining ? "pipelined" : "sequential") ;
+
+    return allSucceeded ;
+}
+
+uint8_t ApiClient::fetched() {
+    return _fetched ;
+}
+
+HttpResult ApiClient::result() {
+    return _result ;
+}
+
+HttpPhase ApiClient::phase() {
+    return _phase ;
+}
+
+bool ApiClient::isPipelining() {
+    return _pipelining ;
+}
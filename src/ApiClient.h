@@ -0,0 +1,139 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef API_CLIENT_H
+#define API_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <functional>
+
+#include "HttpReader.h"
+
+namespace ECG {
+
+/*
+* Fetches a list of endpoints from an API once per poll
+*
+* With pipelining, the requests for every endpoint are sent together over one connection and the
+* responses are handed out in order as they arrive. If the server turns out not to support that,
+* the client goes back to one request at a time. The whole fetch, from the DNS lookup to the
+* last response and including any reconnects, is bounded by Config::requestTimeout per endpoint.
+*/
+class ApiClient {
+
+public:
+
+    /*
+    * Called with each response as soon as it has been read, in the order of the endpoint list
+    *
+    * Parameters:
+    *   endpoint: Index into the endpoint list of the endpoint that sent the response
+    *   response: The response
+    *
+    * Return: true if the response could be used, else false
+    */
+    typedef std::function<bool(uint8_t endpoint, const HttpResponse& response)> ResponseHandler ;
+
+private:
+
+    // Tracker WiFi client for connection to an API
+    //WiFiClientSecure _client ;
+    // TODO: switch back to clientsecure when possible
+    //      Or not? should secure connection be abandoned at the moment?
+    WiFiClient _client ;
+
+    // The server, and the path that every endpoint is under
+    String _host ;
+    uint16_t _port ;
+    String _path ;
+
+    // The endpoints to fetch, in order
+    const String* _endpoints ;
+    uint8_t _endpointCount ;
+
+    // Whether requests are pipelined. Cleared if the server does not support it
+    bool _pipelining ;
+
+    // How the last fetch went: the number of responses read, and if it stopped early,
+    // why and during which phase
+    uint8_t _fetched ;
+    HttpResult _result ;
+    HttpPhase _phase ;
+
+    /*
+    * Build the HTTP get request for an endpoint
+    *
+    * Parameters:
+    *   endpoint: Index into the endpoint list
+    *
+    * Return: the request, ready to be sent
+    */
+    String buildRequest(uint8_t endpoint) ;
+
+public:
+
+    /*
+    * Parameters:
+    *   host: The domain name of the API
+    *   port: The port to connect to
+    *   path: The path that every endpoint is under
+    *   endpoints, endpointCount: The paths of the endpoints to fetch, relative to path.
+    *       They must stay valid while the client is used
+    *   pipelining: Whether to try pipelining the requests
+    */
+    ApiClient(const String& host, uint16_t port, const String& path,
+              const String* endpoints, uint8_t endpointCount, bool pipelining) ;
+
+    /*
+    * Fetch every endpoint, handing each response to handler as it arrives.
+    * A response that the handler can not use does not stop the others from being fetched
+    *
+    * Parameters:
+    *   handler: Called with each response
+    *
+    * Return: true if every endpoint was fetched and the handler could use every response, else false
+    */
+    bool fetch(ResponseHandler handler) ;
+
+    /*
+    * Return: the number of responses read by the last fetch
+    */
+    uint8_t fetched() ;
+
+    /*
+    * Return: HTTP_OK if the last fetch read every response, otherwise why it stopped early
+    */
+    HttpResult result() ;
+
+    /*
+    * Return: the phase during which the last fetch stopped early (PHASE_CONNECT if it could not connect)
+    */
+    HttpPhase phase() ;
+
+    /*
+    * Return: true if requests are still being pipelined, false once the server has shown it does not support it
+    */
+    bool isPipelining() ;
+
+} ; // class ApiClient
+
+} // namespace ECG
+
+#endif // API_CLIENT_H
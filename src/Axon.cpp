@@ -37,7 +37,114 @@ void Axon::setLED(uint8_t LEDCode, bool state) {
     digitalWrite(LEDCode, state) ;
 }
 
-Axon::Axon() {
+bool Axon::restoreState() {
+
+    SavedState state ;
+    if (!_store.load(state)) {
+        Serial.printf("No saved display state found.\n") ;
+        return false ;
+    }
+
+    // Move the outputs straight to where they were, rather than sweeping there
+    for (uint8_t i = 0; i < Config::outputChannelCount; i++) {
+        _display.setPosition(i, state.positions[i]) ;
+    }
+    markBootPhase(_bootTimings.restoredDisplay) ;
+
+    // The values are only reported. They are not added to the history, as it is not known how old they are
+    Serial.printf("Restored display state from boot #%u (retrieved %u s after that boot):\n",
+        state.bootCount, state.retrievedAtSeconds) ;
+    for (uint8_t i = 0; i < Config::valueSourceCount; i++) {
+        if (!state.hasValue[i]) continue ;
+        Serial.printf("  %s: %lf\n", Config::valueSources[i].key.c_str(), state.values[i]) ;
+    }
+
+    return true ;
+}
+
+void Axon::saveState() {
+
+    // Zeroed first so that the padding between fields is always the same, as it is part of the checksum
+    SavedState state ;
+    memset(&state, 0, sizeof(state)) ;
+
+    uint32_t retrievedAt = 0 ;
+    for (uint8_t i = 0; i < Config::valueSourceCount; i++) {
+        state.hasValue[i] = _history[i].count() > 0 ;
+        state.values[i] = _history[i].latest() ;
+        if (_history[i].latestTime() > retrievedAt) {
+            retrievedAt = _history[i].latestTime() ;
+        }
+    }
+    state.retrievedAtSeconds = retrievedAt / 1000 ;
+
+    // Save where the outputs will end up, not where they happen to be mid-sweep
+    for (uint8_t i = 0; i < Config::outputChannelCount; i++) {
+        state.positions[i] = _display.position(i) ;
+    }
+
+    _store.save(state) ;
+}
+
+void Axon::beginWiFi() {
+
+    // WiFi.begin() only needs to be called once, the library handles reconnection after that
+    if ( _hasBegunWiFi ) return ;
+
+    // This call returns immediately; association continues in the background
+    WiFi.begin(Keys::WiFiSSID.c_str(), Keys::WiFiPassword.c_str()) ;
+    _hasBegunWiFi = true ;
+    markBootPhase(_bootTimings.wifiBegun) ;
+}
+
+void Axon::bootWork() {
+
+    // Only one early request is made. If it fails, the main loop will retry as usual
+    if ( _bootFetchDone || !isOnline() ) return ;
+
+    markBootPhase(_bootTimings.wifiConnected) ;
+    _bootFetchDone = true ;
+
+    if ( poll() ) {
+        // Data is ready, so there is no reason to keep the user waiting on the animation
+        if ( Config::skipBootDanceWhenReady ) {
+            _danceCancelled = true ;
+        }
+    }
+}
+
+void Axon::danceSleep(uint32_t milliseconds) {
+
+    // Once the animation is cancelled, the remaining steps run without pausing
+    if ( _danceCancelled ) return ;
+
+    // Outside of boot, this is just an ordinary sleep
+    if ( !_isBooting ) {
+        sleep(milliseconds) ;
+        return ;
+    }
+
+    // During boot, pause in short slices so that bootWork() can run as soon as WiFi is up
+    uint32_t start = millis() ;
+    while ( millis() - start < milliseconds ) {
+        bootWork() ;
+        if ( _danceCancelled ) return ;
+        sleep(10) ;
+    }
+}
+
+void Axon::markBootPhase(uint32_t& phase) {
+    if ( phase == 0 ) {
+        phase = millis() ;
+    }
+}
+
+Axon::Axon() : _api(Config::APIHost, Config::APIPort, Config::APIPath,
+                    Config::APIEndpoints, Config::APIEndpointCount, Config::usePipelining) {
+
+    // Clear all boot phase timestamps before anything else so the first one can be recorded
+    _bootTimings = BootTimings() ;
+    markBootPhase(_bootTimings.constructed) ;
 
     // Begin "serial" (really USB) output at 115200 baud
     Serial.begin(115200) ;
@@ -50,31 +157,74 @@ Axon::Axon() {
     setLED(RED_LED, LED_OFF) ;
     setLED(BLUE_LED, LED_OFF) ;
 
-    // Connect the servo arm
-    _servo.attach(SERVO_PIN) ;
+    // Connect the display outputs, with any servo arms set to center (90 degrees)
+    _display.begin(90) ;
 
-    // Set the servo to center (90 degrees)
-    _servo.write(90) ;
+    // Then show whatever was on display before the last reboot, if it was saved
+    bool restored = restoreState() ;
 
-    // Demonstrate to the user that components are functioning properly
-    debugDance() ;
 
     // The device has not connecte to WiFi yet, so hasBegunWiFi should be false
     _hasBegunWiFi = false ;
+    _hasConnectedWiFi = false ;
+
+    // Nothing has failed yet
+    _lastFailure = FAILURE_NONE ;
+
+    // Seed the random number generator used for retry jitter, so that devices
+    // do not all retry at the same moments after a shared outage
+    randomSeed(ESP.getChipId() ^ micros()) ;
 
     // Set the initial payload to an empty string
     _payload = "" ;
+    _stats = PollMetrics() ;
+    _wifiWasLost = false ;
+    _hasNewValues = false ;
 
-    // If the flag is toggled in Axon.h, enable the output of device debug information
+    // If the flag is toggled in Options.h, enable the output of device debug information
     if (SHOW_WIFI_DIAGNISTICS) {
         Serial.setDebugOutput(true) ;
         WiFi.printDiag(Serial) ;
     }
 
-    // If all the above are successful, the device is now in a valid state.
-    // Next, it will attempt to conenct to WiFi
+    // The device is valid unless something below says otherwise
     // TODO actually validate that the above was successful
     _valid = true ;
+
+    // Start associating with the network now, so that it happens while the boot animation plays
+    // rather than after it
+    _isBooting = true ;
+    _bootFetchDone = false ;
+    beginWiFi() ;
+
+    // The metrics server can listen before the network is up
+    _metrics.begin() ;
+
+    // Demonstrate to the user that components are functioning properly
+    // The first API request is made in the background of this if WiFi connects in time
+    // The animation is skipped if it would move the arms away from a restored display
+    _danceCancelled = restored && Config::skipBootDanceWhenRestored ;
+    debugDance() ;
+
+    // Make sure the animation leaves the LEDs in a sensible state if it was cut short.
+    // The animation blinks the action LED, so show again what the boot request found, if it was made
+    if ( _bootFetchDone ) {
+        updateActionLED() ;
+    }
+    else {
+        setLED(ACTION_LED, LED_OFF) ;
+    }
+    setLED(NETWORK_LED, isOnline() ? LED_ON : LED_OFF) ;
+
+    _isBooting = false ;
+    _danceCancelled = false ;
+
+    // If data arrived during the animation, show it right away instead of waiting for the main loop.
+    // That counts as the first poll, so wait out the normal interval before the main loop polls again
+    if ( _bootTimings.firstValue != 0 ) {
+        updateDisplay() ;
+        sleep(nextPollDelay()) ;
+    }
 }
 
 bool Axon::isValid() {
@@ -91,8 +241,14 @@ bool Axon::isOnline() {
 }
 
 // Simple wrapper function to minimize library calls and redirect control flow through object framework
+// The display outputs keep moving towards their targets while the device waits
 void Axon::sleep(uint32_t milliseconds) {
-    delay(milliseconds) ;
+    uint32_t start = millis() ;
+    while ( millis() - start < milliseconds ) {
+        _display.tick() ;
+        _metrics.handle() ;
+        delay(1) ;
+    }
 }
 
 /*
@@ -110,48 +266,54 @@ bool Axon::connectToWiFi() {
 
     // Not sure if this case is neccessary..
     // Case device already connected to WiFi
-    if ( isOnline() ) return true ;
+    // The connection may have come up on its own during boot, so note that it has been made
+    if ( isOnline() ) {
+        _hasConnectedWiFi = true ;
+
+        // Count the connection coming back after being lost
+        if ( _wifiWasLost ) {
+            _wifiWasLost = false ;
+            _stats.wifiReconnects++ ;
+            setLED(NETWORK_LED, LED_ON) ;
+        }
+        return true ;
+    }
 
     // Case first connection
-    if ( _hasBegunWiFi == false) {
-         WiFi.begin(Keys::WiFiSSID.c_str(), Keys::WiFiPassword.c_str()) ;
-        _hasBegunWiFi = true ;
+    // WiFi.begin() will normally have been called during boot already, in which case
+    // the time spent on the boot animation counts towards the timeout below
+    if ( _hasConnectedWiFi == false ) {
+        beginWiFi() ;
 
         // The device is not properly connected to the network unless the WiFi.status()
         // method returns WL_CONNECTED and the device also has a valid local IP address
         // Also, break out of the connection loop after thirty seconds and let the user
-        // know there was an error connecting to WiFi. The counter variable i will be 
-        // used for this purpose
-        uint32_t i = 0 ;
-
-        // This variable stores the number of half seconds (1000ms/2) that the device attempts
-        // to connect to WiFi before timing out. The choice of units is due to the half second (500ms)
-        // delay between the printing of '.'s
-        uint32_t halfSecondsTimeout = 60 ;
+        // know there was an error connecting to WiFi.
+        const uint32_t msTimeout = 30000 ;
 
         Serial.printf("Connecting to WiFi network %s ", Keys::WiFiSSID.c_str()) ;
         while ( isOnline() == false )
         {
+            // Give up after the timeout and let the retry scheduler decide when to try again.
+            // WiFi.begin() has already been called, so the library keeps associating in the background
+            // and later calls to this function return quickly
+            if ( millis() - _bootTimings.wifiBegun >= msTimeout ) {
+                Serial.printf("\nUnable to connect to WiFi network %s. Time out after 30 seconds.\n",
+                    Keys::WiFiSSID.c_str()) ;
+                setLED(NETWORK_LED, LED_OFF) ;
+                _lastFailure = FAILURE_WIFI ;
+                return false ;
+            }
+
             // An "progress bar" ticker that shows the user that the connection is in progress
             Serial.printf(".") ;
 
             sleep(500) ;
-
-            // If the following print statement is removed, the device will crash on the subsequent line
-            // The above statment is no longer true for some reason...
-
-            if ( i >= halfSecondsTimeout ) {
-                Serial.printf("\nUnable to connect to WiFi network %s. Time out after 30 seconds.\n"
-                    "Switching to offline party mode...\n", Keys::WiFiSSID.c_str()) ;
-                // This call will never return. It activates "party mode" (basically a screensaver without a screen)
-                endlessDebugFlash() ;
-            }
-
-            // As our timer variable, i must be incremented at the end of each loop iteration
-            i++ ;
         }
         // If the control flow makes it past the preceeding while loop, the device should be connected to WiFi.
         // Make a note of any cases in which control flow reaches this point without a successful WiFi connection
+        _hasConnectedWiFi = true ;
+        markBootPhase(_bootTimings.wifiConnected) ;
 
         setLED(NETWORK_LED, LED_ON) ;
         Serial.printf("\nSuccessfully connected to WiFi network %s.\nLocal IP address: %s.\n",
@@ -172,9 +334,11 @@ bool Axon::connectToWiFi() {
         setLED(NETWORK_LED, LED_ON) ;
     }
 
-    // If the device still is not online, it is in an invalid state (perhaps it was moved)
+    // If the device still is not online, the connection has dropped (perhaps it was moved)
+    // This is usually temporary, so leave it to the retry scheduler
     if (!isOnline()) {
-        _valid = false ;
+        _wifiWasLost = true ;
+        _lastFailure = FAILURE_WIFI ;
         return false ;
     }
     // Otherwise, all is fine and dandy. Return successfully and continue business as usual.
@@ -185,112 +349,150 @@ bool Axon::connectToWiFi() {
 
 bool Axon::callAPI() {
 
-    // First, we must establish a connection to an API
-    Serial.printf("Connecting to %s on port %d... \n", Config::APIHost.c_str(), Config::APIPort) ;
-
-    if ( !_client.connect(Config::APIHost, Config::APIPort) ) {
-        Serial.printf("Connection failed!\n") ;
+    // If the option is set in Options.h, fail during a fixed window of every period to test recovery
+    if ( SIMULATE_OUTAGES &&
+        ( millis() / 1000 ) % SIMULATED_OUTAGE_PERIOD_SECONDS < SIMULATED_OUTAGE_SECONDS ) {
+        Serial.printf("Simulated outage! Connection failed!\n") ;
+        _lastFailure = FAILURE_CONNECT ;
         return false ;
     }
 
-    // Next, we will construct the HTTP get request
-    String getRequest = "GET " + Config::APIPath + Config::APIEndpoint + " HTTP/1.1\r\n" +
-                        "Host: " + Config::APIHost + "\r\n" +
-                        "Connection: close\r\n\r\n" ;
-
-    // Display request being sent for debug purposes if the option has been set in Axon.h
-    if (SHOW_HTTP_HEADERS) {
-        Serial.printf("Sending the following request:\n%s\n", getRequest.c_str() ) ;
-    }
-                    
-    // Now, we send this to the server
-    _client.print(getRequest) ;
-
-    // The client now reads the response sent by the server
+    uint32_t cycleStart = millis() ;
+    _stats.lastParseUs = 0 ;
+    _stats.lastPayloadBytes = 0 ;
 
-    //TODO: actually save instead of dumping
+    // Each response is handled as soon as it has been read
+    bool allSucceeded = _api.fetch([this](uint8_t endpoint, const HttpResponse& response) {
+        return handleResponse(endpoint, response) ;
+    }) ;
 
-    // Stores each line read from server for each read from the socket
-    String line ;
-
-    // Stores the http response code of a given response in order to handle non-200 responses
-    String responseCode ;
-
-    // This variable tracks whether the current iteration is the first in order to handle the HTTP response code
-    bool isFirstLine = true ;
-
-    // Get the HTTP response from the server, but ignore lines until the end of the header (i.e. "\r\n")
-    while (_client.connected()) {
-        line = _client.readStringUntil('\n') ;
+    // Case: not every endpoint could be fetched
+    if (_api.result() != HTTP_OK) {
+        _lastFailure = _api.result() == HTTP_TIMEOUT ? FAILURE_TIMEOUT :
+                       _api.phase() == PHASE_CONNECT ? FAILURE_CONNECT : FAILURE_HTTP_SERVER ;
+    }
+    recordRequestTime(millis() - cycleStart) ;
 
-        // TODO: read the http response code
-        // If this is the first line, the HTTP response code is on this line
-        if (isFirstLine == true) {
-            // It is always in the same place as well, how convienient to have such a standardized protocol at times like these
-            
-            // The index at which the response code begins is the size of the preceeding substring in the response
-            const uint8_t indexOfResponseSubstring = String("HTTP/1.1 ").length() ;
+    return allSucceeded ;
+}
 
-            // An http response code is 3 digits long
-            const uint8_t httpResponseCodeLength = 3 ;
-            
-            // So, the response code is the substring of the first line from its begining index until its begining index plus its length
-            responseCode = line.substring(indexOfResponseSubstring, indexOfResponseSubstring + httpResponseCodeLength) ;
+bool Axon::handleResponse(uint8_t endpoint, const HttpResponse& response) {
 
-            // Take this opportunity to print some debug
-            if (SHOW_HTTP_HEADERS) {
-                Serial.printf("RESPONSE FOLLOWS\n") ;
-            }
+    // Case: Successful get, but with nothing in it
+    // Treated like a server error, as retrying soon will probably get a proper response
+    if (response.status == 200 && response.body.length() == 0) {
+        Serial.printf("API endpoint %s returned an empty response.\n", Config::APIEndpoints[endpoint].c_str()) ;
+        _lastFailure = FAILURE_HTTP_SERVER ;
+        return false ;
+    }
+    // Case: Successful get
+    else
+    if (response.status == 200) {
+        _stats.lastPayloadBytes += response.body.length() ;
+
+        // The server says which format it chose. Anything other than CBOR is treated as JSON
+        // HttpReader lower-cases the content type, as media types are case-insensitive
+        bool isCbor = response.contentType.startsWith("application/cbor") ;
+        bool parsed ;
+
+        uint32_t parseStart = micros() ;
+        if (isCbor) {
+            _stats.cborResponses++ ;
+            parsed = parseCbor(endpoint, response.body) ;
         }
+        else {
+            _stats.jsonResponses++ ;
+            _payload = response.body ;
+            parsed = parseJson(endpoint) ;
 
-        // As above, display headers if the following option has been set
-        if (SHOW_HTTP_HEADERS) {
-            Serial.printf("%s\n", line.c_str()) ;
+            // The payload is not needed once its values have been extracted
+            _payload = "" ;
         }
+        _stats.lastParseUs += micros() - parseStart ;
 
-        // After a single itertion, this should be perpetually false
-        isFirstLine = false ;
-
-        // If the string of characters on a line before the newline is just an '\r', the header is over
-        if (line == "\r") break ;
+        return parsed ;
     }
+    // Case: Resource not found
+    else
+    if (response.status == 404) {
+        Serial.printf("API endpoint %s not found! Is the config invalid?\n", Config::APIEndpoints[endpoint].c_str()) ;
+        _lastFailure = FAILURE_NOT_FOUND ;
+        return false ;
+    }
+    // Case: Unkown error
+    else {
+        Serial.printf("An unknown error occured (HTTP %d). This might not be local.\n", response.status) ;
+        _lastFailure = FAILURE_HTTP_SERVER ;
+        return false ;
+    }
+}
 
-    /*
-        The retrieved JSON is preceeded and suceeded by strange three digit hex values and I do not know why yet
-        Until then, I will just ignore the first line and save the second, the one with the actual JSON
-
-    */
-
-    // Case: Successful get
-    if (responseCode == "200") {
+void Axon::recordRequestTime(uint32_t milliseconds) {
+    _stats.lastRequestMs = milliseconds ;
+    if (milliseconds > _stats.worstRequestMs) {
+        _stats.worstRequestMs = milliseconds ;
+    }
+    Serial.printf("Fetching took %u ms (longest so far: %u ms, limit: %u ms).\n",
+        _stats.lastRequestMs, _stats.worstRequestMs, Config::requestTimeout * Config::APIEndpointCount) ;
+}
 
-        // Ignore first line
-        _client.readStringUntil('\n') ;
+bool Axon::poll() {
 
-        // Save second line
-        _payload = _client.readStringUntil('\n') ;
+    // Each step only runs if the one before it succeeded
+    // Some values may be retrieved even if others fail, so those are tracked separately
+    _hasNewValues = false ;
+    bool success = connectToWiFi() && callAPI() ;
 
-        // Ignore the rest
-        _client.readString() ;
-        return true ;
+    _stats.polls++ ;
+    if (success) {
+        _lastFailure = FAILURE_NONE ;
+        _stats.successes++ ;
+        _retry.recordSuccess() ;
     }
-    // Case: Resource not found
+    // Case: some endpoints failed but others delivered values
+    // The failure is counted, but the retry scheduler is not told about it. Otherwise one broken
+    // endpoint (e.g. a 404) would open the circuit and slow down polling of all the healthy ones
     else
-    if (responseCode == "404") {
-        Serial.printf("API endpoint not found! Device config invalid.\n") ;
-        _payload = "" ;
-        _valid = false ;
-        return false ;
+    if (_hasNewValues) {
+        Serial.printf("Poll partly failed (cause: %s). Keeping last value for the failed endpoints.\n",
+            RetryScheduler::causeName(_lastFailure)) ;
+        _stats.failures[_lastFailure]++ ;
+        _retry.recordSuccess() ;
     }
-    // Case: Unkown error
+    // Case: nothing was retrieved
     else {
-        Serial.printf("An unknown error occured. This might not be local.\n") ;
-        _payload = "" ;
-        return false ;
+        Serial.printf("Poll failed (cause: %s). Keeping last value.\n", RetryScheduler::causeName(_lastFailure)) ;
+        _stats.failures[_lastFailure]++ ;
+        _retry.recordFailure(_lastFailure) ;
     }
+
+    // Format the metrics now, so that scrapes do no work beyond copying them out
+    _stats.circuitOpen = _retry.isCircuitOpen() ;
+    _stats.meanTimeToRecoveryMs = _retry.meanTimeToRecovery() ;
+    _metrics.update(_stats, _history) ;
+
+    updateActionLED() ;
+
+    return _hasNewValues ;
+}
+
+bool Axon::isStale() {
+    uint32_t now = millis() ;
+    for (uint8_t i = 0; i < Config::valueSourceCount; i++) {
+        if (_history[i].isStale(now, Config::staleAfter)) return true ;
+    }
+    return false ;
 }
 
-bool Axon::parseJson_manualFallback() {
+void Axon::updateActionLED() {
+    setLED(ACTION_LED, ( _retry.isCircuitOpen() || isStale() ) ? LED_ON : LED_OFF) ;
+}
+
+uint32_t Axon::nextPollDelay() {
+    return _retry.nextDelay() ;
+}
+
+bool Axon::parseJson_manualFallback(const String& key, double& value) {
     
     // If ArduinoJson is unable to parse the payload, it may be incomplete
     // We will attempt to manually parse the string ourselves using the library
@@ -298,16 +500,16 @@ bool Axon::parseJson_manualFallback() {
 
     // First we check to see if the target JSON key is in the retrieved string
     Serial.printf("Searching for key (%s) in data (%s)...\n",
-        Config::targetKey.c_str(), _payload.c_str()) ;
+        key.c_str(), _payload.c_str()) ;
     
-    uint16_t indexOfKey = _payload.indexOf(Config::targetKey) ;
+    int indexOfKey = _payload.indexOf(key) ;
     if ( indexOfKey == -1 ) {
         Serial.printf("could not find target key manually\n") ;
         return false ;
     }
     Serial.printf("index of key is:%d\n",indexOfKey) ;
 
-    uint16_t lengthOfKey = Config::targetKey.length() ;
+    uint16_t lengthOfKey = key.length() ;
 
     // If the target key is present, the data, if retrieved, will be at the index of the target key
     // plus the length of the key plus two more characters (A '\"' and a ',')
@@ -346,17 +548,17 @@ bool Axon::parseJson_manualFallback() {
     // TODO: check if this is sufficient validation
 
     // If the control flow has got to this point, the locally scoped targetValue should be
-    // correct, so copy it to the object's instance _targetValue before returning with success.
-    _targetValue = targetValue ;
+    // correct, so convert it for the caller before returning with success.
+    value = strtod(targetValue.c_str(), nullptr) ;
 
     // At this point, the manual parse has succeeded. Cool.
     return true ;
 
  }
 
-bool Axon::parseJson() {
+bool Axon::parseJson(uint8_t endpoint) {
 
-    // If the option is toggled in Axon.h, show the payload to be parsed
+    // If the option is toggled in Options.h, show the payload to be parsed
     if (SHOW_PAYLOAD) {
         Serial.printf(
             "Parsing the following data: %s\n",
@@ -367,8 +569,11 @@ bool Axon::parseJson() {
     }
 
     // Case: invalid/no payload
+    // Nothing was received to parse, which is more likely a hiccup (e.g. a proxy) than bad config,
+    // so this is a transient failure rather than a parse failure
     if (_payload == "") {
         // Fail
+        _lastFailure = FAILURE_HTTP_SERVER ;
         return false ;
     }
 
@@ -378,64 +583,128 @@ bool Axon::parseJson() {
     JsonObject& dataRoot = jsonBuffer.parseObject(_payload) ;
 
     // Check for parsing failure
-    if (dataRoot.success() == false) {
-        Serial.printf("There was an error parsing the retrieved JSON!\n") ;
+    // If ArduinoJson fails, the manual and hastily written manual fallback is tried before failing
+    bool useFallback = dataRoot.success() == false ;
+    if (useFallback) {
+        Serial.printf("There was an error parsing the retrieved JSON!\n"
+            "Attempting to parse the JSON manually...\n") ;
+    }
 
-        // Try the manual and hastily written manual fallback before failing
-        Serial.printf("Attempting to parse the JSON manually...\n") ;
-        if ( parseJson_manualFallback() == false ) {
-            
-            // If the second parsing attempt fails, just admid 
-            Serial.printf("Manual parse failed! Is the config invalid?\n") ;
+    // Get the value corresponding to each key specified in config for this endpoint and save it
+    // Keys that can not be found keep their previous value
+    // TODO: method to get nested values
+    uint8_t found = 0 ;
+    for (uint8_t i = 0; i < Config::valueSourceCount; i++) {
+        if (Config::valueSources[i].endpoint != endpoint) continue ;
 
-            // The device is in an invalid state if the JSON is successfully retrieved but unparsable
-            _valid = false ;
+        const String& key = Config::valueSources[i].key ;
+        double value ;
 
-            return false ;
+        if (useFallback) {
+            if ( parseJson_manualFallback(key, value) == false ) {
+                Serial.printf("Manual parse failed for key %s!\n", key.c_str()) ;
+                continue ;
+            }
+            Serial.printf("Manual parse found %s: %lf\n", key.c_str(), value) ;
         }
         else {
-            Serial.printf("Manual parse found value: %s\n", _targetValue.c_str()) ;
-            return true ;
+            if ( !dataRoot.containsKey(key) ) {
+                Serial.printf("Key %s is not in the retrieved JSON!\n", key.c_str()) ;
+                continue ;
+            }
+            value = dataRoot[key].as<double>() ;
+            Serial.printf("ArduinoJson parse found %s: %lf\n", key.c_str(), value) ;
         }
+
+        _history[i].add(millis(), value, Config::ewmaWeight) ;
+        found++ ;
     }
-    // If there was no error, get the value corresponding to the key specified in config and save it
-    // TODO: method to get nested values
-    else {
-        String temp = dataRoot[Config::targetKey] ;
-        _targetValue = temp ;
-        Serial.printf("ArduinoJson parse found value: %s\n", _targetValue.c_str()) ;
-        return true ;
+
+    // If none of the keys could be found, just admit it
+    // The JSON was retrieved but is unusable. This is treated as a permanent failure
+    // so the device keeps showing the last good values and only checks back occasionally
+    if (found == 0) {
+        Serial.printf("No values found! Is the config invalid?\n") ;
+        _lastFailure = FAILURE_PARSE ;
+        return false ;
     }
+
+    _hasNewValues = true ;
+    markBootPhase(_bootTimings.firstValue) ;
+    return true ;
 }
 
-bool Axon::updateDisplay() {
+bool Axon::parseCbor(uint8_t endpoint, const String& body) {
 
-    // This function converts the distance of the retrieved value between the begining and the end of the specified range to an angle
+    // The decoder reads the body where it is, so nothing is copied
+    CborDecoder decoder((const uint8_t*) body.c_str(), body.length()) ;
 
-    double doubleTargetValue = strtod(_targetValue.c_str(),nullptr) ;
+    // Gather the keys taken from this endpoint, so that they are all found in one pass over the body
+    const String* keys[Config::valueSourceCount] ;
+    uint8_t sources[Config::valueSourceCount] ;
+    double values[Config::valueSourceCount] ;
+    bool found[Config::valueSourceCount] ;
+    uint8_t count = 0 ;
+    for (uint8_t i = 0; i < Config::valueSourceCount; i++) {
+        if (Config::valueSources[i].endpoint != endpoint) continue ;
+        keys[count] = &Config::valueSources[i].key ;
+        sources[count] = i ;
+        count++ ;
+    }
+
+    decoder.findNumbers(keys, count, values, found) ;
 
-    Serial.printf("display value of %lf between %lf and %lf\n", doubleTargetValue,
-         Config::displayLowBound, Config::displayHighBound) ;
+    uint8_t foundCount = 0 ;
+    for (uint8_t k = 0; k < count; k++) {
+        if (!found[k]) {
+            Serial.printf("Key %s is not in the retrieved CBOR!\n", keys[k]->c_str()) ;
+            continue ;
+        }
+        Serial.printf("CBOR parse found %s: %lf\n", keys[k]->c_str(), values[k]) ;
 
-    // Case: retrieved value is below or at lower bound of display range
-    if (doubleTargetValue <= Config::displayLowBound) {
-        // Move servo to lowest possible position 
-        moveServo(0) ;
+        _history[sources[k]].add(millis(), values[k], Config::ewmaWeight) ;
+        foundCount++ ;
     }
-    else
-    // Case: retrieved values is above or at higher bound of display range
-    if (doubleTargetValue >= Config::displayHighBound) {
-        // Move servo to highest possible position
-        moveServo(180) ;
+
+    // As for JSON, finding none of the keys means the data is unusable
+    if (foundCount == 0) {
+        Serial.printf("No values found! Is the config invalid?\n") ;
+        _lastFailure = FAILURE_PARSE ;
+        return false ;
     }
-    // Case: the retrieved value is in bounds
-    else {
-        // Calculate appropriate angle
-        Serial.printf("divide %lf by %lf to get %lf degree display angle.\n", doubleTargetValue,
-            Config::displayHighBound - Config::displayLowBound,
-            doubleTargetValue / ( Config::displayHighBound - Config::displayLowBound )) ;
-        moveServo( (uint16_t) round( 180.0 * ( ( doubleTargetValue - Config::displayLowBound )/ ( Config::displayHighBound - Config::displayLowBound ) ) ) ) ;
+
+    _hasNewValues = true ;
+    markBootPhase(_bootTimings.firstValue) ;
+    return true ;
+}
+
+bool Axon::updateDisplay() {
+
+    // Hand each retrieved value to the display driver, which works out the position of every
+    // output bound to it. Nothing moves here; outputs move together while the device sleeps
+    bool updated = false ;
+    for (uint8_t i = 0; i < Config::valueSourceCount; i++) {
+        if (_history[i].count() == 0) continue ;
+
+        Serial.printf("display %s value of %lf (average %lf, %lf per minute, range %lf to %lf)\n",
+            Config::valueSources[i].key.c_str(), _history[i].latest(), _history[i].ewma(),
+            _history[i].deltaPerMinute(), _history[i].min(), _history[i].max()) ;
+        _display.setValue(i, _history[i]) ;
+        updated = true ;
+    }
+
+    if (!updated) return false ;
+
+    // Remember what is on display in case of a reboot
+    saveState() ;
+
+    // The first time a real value is shown marks the end of the boot sequence
+    if ( _bootTimings.firstDisplay == 0 ) {
+        markBootPhase(_bootTimings.firstDisplay) ;
+        reportBootTimings() ;
     }
+
+    return true ;
 }
 
 // TODO: carefully read arduino WiFi documentation
@@ -482,45 +751,46 @@ void Axon::debugDance(uint16_t speed) {
     for(uint8_t i = 0; i < 2; i++) {
         // Quick red blink
         setLED(RED_LED,LED_ON) ;
-        sleep(200 * speed) ;
+        danceSleep(200 * speed) ;
         setLED(RED_LED,LED_OFF) ;
-        sleep(200 * speed) ;
+        danceSleep(200 * speed) ;
 
         // Quick blue blink
         setLED(BLUE_LED,LED_ON) ;
-        sleep(200 * speed) ;
+        danceSleep(200 * speed) ;
         setLED(BLUE_LED,LED_OFF) ;
-        sleep(200 * speed) ;
+        danceSleep(200 * speed) ;
     }
 
     // Small extension of final sleep period
-    sleep(200 * speed) ;
+    danceSleep(200 * speed) ;
 
     // Triple blink of both LEDs
     for(uint8_t i = 0; i < 3; i++) {
         setLED(BLUE_LED,LED_ON) ;
         setLED(RED_LED,LED_ON) ;
-        sleep(200 * speed) ;
+        danceSleep(200 * speed) ;
         setLED(BLUE_LED,LED_OFF) ;
         setLED(RED_LED,LED_OFF) ;
-        sleep(200 * speed) ;
+        danceSleep(200 * speed) ;
     }
 
     // Quick servo twist to 0 and 180, then back to 90 (center positoon)
-    moveServo(0,180 * speed) ;
-    moveServo(180,180 * speed) ;
-    moveServo(90,180 * speed) ;
-    sleep(200 * speed) ;
+    // The sweeps are skipped if the dance has been cut short
+    if ( !_danceCancelled ) moveServo(0,180 * speed) ;
+    if ( !_danceCancelled ) moveServo(180,180 * speed) ;
+    if ( !_danceCancelled ) moveServo(90,180 * speed) ;
+    danceSleep(200 * speed) ;
 
 
     // Another Triple blink of both LEDs
     for(uint8_t i = 0; i < 3; i++) {
         setLED(BLUE_LED,LED_ON) ;
         setLED(RED_LED,LED_ON) ;
-        sleep(200 * speed) ;
+        danceSleep(200 * speed) ;
         setLED(BLUE_LED,LED_OFF) ;
         setLED(RED_LED,LED_OFF) ;
-        sleep(200 * speed) ;
+        danceSleep(200 * speed) ;
     }
 }
 
@@ -547,49 +817,53 @@ void Axon::moveServo(uint16_t angle, uint16_t speed) {
         speed = DEFAULT_SERVO_SPEED ;
     }
 
-    // A second's worth of milliseconds 
-    uint32_t msSecond = 1000 ;
-
-    // Turn the speed parameter into a usable delay between angle increments
-    // by dividing a second's worth of milliseconds by the integer speed parameter
-    // using floating point division, effectively treating speed as 'degrees per second'
-    uint32_t adjustedDelay = (uint32_t) ( round ((double) msSecond / speed )) ;
-
     // If the option is set, tell the user that the servo is being moved and to where
     if (SHOW_SERVO_MOVES) {
         Serial.printf("Begin move to angle %d\n", fixedAngle) ;
     }
 
-    // Case: requested angle is equal to current angle
-    if (fixedAngle == _servo.read()) {
-        // If the option is set, tell the user there is no need to move
-        if (SHOW_SERVO_MOVES) {
-            Serial.printf("No Write. Angle is %d\n", _servo.read()) ;
-        }
-        return ;
-    }
-    // Case: Requested angle is smaller than current angle
-    else
-    if (fixedAngle > _servo.read()) {
-        for (; fixedAngle > _servo.read() ; _servo.write(_servo.read() + 1)) {
-            sleep(adjustedDelay) ;
-        }
-        return ;
-    }
-    // Case: Requested angle is larger than current angle
-    else
-    if (fixedAngle < _servo.read()) {
-        for (; fixedAngle < _servo.read() ; _servo.write(_servo.read() - 1)) {
-            sleep(adjustedDelay) ;
+    // Every servo arm moves at once, so this takes as long as a single sweep
+    // no matter how many arms are attached
+    _display.setServoTargets(fixedAngle, speed) ;
+    while (_display.tick()) {
+        // During the boot animation, make the first API request as soon as WiFi is up rather than
+        // after the sweep, and leave the arms where they are if the animation is then cancelled
+        if ( _isBooting ) {
+            bootWork() ;
+            if ( _danceCancelled ) return ;
         }
-        return ;
+        delay(1) ;
     }
-    
-    // TODO: refactor into one loop with exit condition bool as loop condition
-    // coeffifient of (-1) or (1) to fix increment for different directions
 }
 
 void Axon::moveServo(uint16_t angle) {
     // This function simply calls the (int,int) version of itself with the default speed value
     moveServo(angle, DEFAULT_SERVO_SPEED) ;
 }
+
+void Axon::reportBootTimings() {
+
+    if ( !SHOW_BOOT_TIMINGS ) return ;
+
+    // Phases that were never reached are reported as such rather than as 0 ms
+    const uint32_t* phases[] = {
+        &_bootTimings.constructed,
+        &_bootTimings.restoredDisplay,
+        &_bootTimings.wifiBegun,
+        &_bootTimings.wifiConnected,
+        &_bootTimings.firstValue,
+        &_bootTimings.firstDisplay
+    } ;
+    const char* names[] = { "constructed", "restored display", "wifi begun", "wifi connected", "first value", "first display" } ;
+
+    // Time to the first meaningful display is the restored display if there was one, otherwise the first display
+    Serial.printf("Boot timings (ms since power-on):\n") ;
+    for (uint8_t i = 0; i < sizeof(phases) / sizeof(phases[0]); i++) {
+        if (*phases[i] == 0) {
+            Serial.printf("  %-15s not reached\n", names[i]) ;
+        }
+        else {
+            Serial.printf("  %-15s %u\n", names[i], *phases[i]) ;
+        }
+    }
+}
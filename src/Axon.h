@@ -19,28 +19,8 @@
 #ifndef AXON_H
 #define AXON_H
 
-// TODO: Should these be global variables rather than preprocessor definitions?
-
-// Debugging options
-#define SHOW_WIFI_DIAGNISTICS 0
-#define SHOW_HTTP_HEADERS 0
-#define SHOW_PAYLOAD 0
-#define SHOW_SERVO_MOVES 0
-
-// Define LED codes by color
-#define RED_LED LED_BUILTIN
-#define BLUE_LED 2
-
-// Define LED codes by purpose
-#define ACTION_LED RED_LED
-#define NETWORK_LED BLUE_LED
-
-// Define LED toggle macros
-#define LED_ON false
-#define LED_OFF true
-
-// Define pin # that controls servo
-#define SERVO_PIN 14
+// Debugging and testing options, and pin assignments
+#include "Options.h"
 
 // Arduino libraries
 #include <Arduino.h>
@@ -61,6 +41,27 @@
 #include "Keys.h"
 #include "Config.h"
 
+// Drives the servos and LEDs listed in Config.h
+#include "DisplayDriver.h"
+
+// Retry and circuit breaker logic for failed polls
+#include "RetryScheduler.h"
+
+// Deadline bounded reading of HTTP responses
+#include "HttpReader.h"
+
+// Fetching every API endpoint in one poll
+#include "ApiClient.h"
+
+// Metrics endpoint for monitoring
+#include "MetricsServer.h"
+
+// Saving the display state across reboots
+#include "StateStore.h"
+
+// Decoding of binary (CBOR) responses
+#include "CborDecoder.h"
+
 namespace ECG {
 
 class Axon {
@@ -73,21 +74,63 @@ private:
     // Stores truth value for whether device has attempted to connect to WiFi since booting
     bool _hasBegunWiFi ;
 
-    // Controls the servo arm attached to SERVO_PIN during object construction
-    Servo _servo ;
+    // Stores truth value for whether device has ever been online since booting
+    // The first connection is waited on, later ones are left to the WiFi library
+    bool _hasConnectedWiFi ;
+
+    // True while the constructor is still running the boot sequence
+    bool _isBooting ;
+
+    // Set once the boot sequence has attempted its early API request
+    bool _bootFetchDone ;
+
+    // Set when the boot animation should stop early (e.g. because data is already available)
+    bool _danceCancelled ;
 
-    // Tracker WiFi client for connection to an API
-    //WiFiClientSecure _client ;
-    // TODO: switch back to clientsecure when possible
-    //      Or not? should secure connection be abandoned at the moment?
-    WiFiClient _client ;
+    // Timestamps (millis() since power-on) for each phase of the boot sequence
+    // A value of 0 means the phase has not been reached yet
+    struct BootTimings {
+        uint32_t constructed ;
+        uint32_t restoredDisplay ;
+        uint32_t wifiBegun ;
+        uint32_t wifiConnected ;
+        uint32_t firstValue ;
+        uint32_t firstDisplay ;
+    } _bootTimings ;
+
+    // Controls the servo arms and LEDs described by Config::outputChannels
+    DisplayDriver _display ;
+
+    // Fetches Config::APIEndpoints from the API
+    ApiClient _api ;
 
     // Raw data recieved from API
     // Should be empty unless the device is invalid
     String _payload ;
 
-    // Data to be displayed using servo
-    String _targetValue ;
+    // Counters about polls, served by _metrics
+    PollMetrics _stats ;
+
+    // Serves _stats and the current values on the LAN
+    MetricsServer _metrics ;
+
+    // Set when the WiFi connection drops, so that reconnections can be counted
+    bool _wifiWasLost ;
+
+    // Set when at least one value has been retrieved during the current poll
+    bool _hasNewValues ;
+
+    // Keeps the last values and display positions across reboots
+    StateStore _store ;
+
+    // Data to be displayed: the recent samples of each entry in Config::valueSources
+    SourceHistory _history[Config::valueSourceCount] ;
+
+    // Decides when to poll next based on the success or failure of previous polls
+    RetryScheduler _retry ;
+
+    // Cause of the most recent failure of connectToWiFi(), callAPI() or parseJson()
+    FailureCause _lastFailure ;
 
     /*
     * Set a device LED on or off
@@ -101,7 +144,8 @@ private:
     void setLED(uint8_t LEDCode, bool state) ;
 
     /*
-    * Move the servo to an angle between 0 and 180 at a given speed
+    * Move every servo to an angle between 0 and 180 at a given speed, returning once they get there
+    * During boot, bootWork() runs while the servos move, and this returns early if the animation is cancelled
     * If an angle outside these bounds, the supplied value will be
     * mod'd by 181 to ensure the user's compliance with these requirements
     * 
@@ -115,6 +159,67 @@ private:
     void moveServo(uint16_t angle, uint16_t speed) ;
     void moveServo(uint16_t angle) ;
 
+    /*
+    * Handle the response from an endpoint, extracting its values if the request succeeded
+    *
+    * Parameters:
+    *   endpoint: Index into Config::APIEndpoints of the endpoint that sent the response
+    *   response: The response
+    *
+    * Return: true if the values for the endpoint were found, else false
+    */
+    bool handleResponse(uint8_t endpoint, const HttpResponse& response) ;
+
+    /*
+    * Record how long fetching every endpoint took, for diagnostics
+    *
+    * Parameters:
+    *   milliseconds: Time from the start of the first request until the last one finished or was abandoned
+    */
+    void recordRequestTime(uint32_t milliseconds) ;
+
+    /*
+    * Show the values and display positions saved before the last reboot, if there are any
+    *
+    * Return: true if a saved state was restored, else false
+    */
+    bool restoreState() ;
+
+    /*
+    * Save the current values and display positions so that they can be restored after a reboot
+    */
+    void saveState() ;
+
+    /*
+    * Start associating with the WiFi network described in Keys.h without waiting for
+    * the connection to complete. Does nothing if this has already been done.
+    */
+    void beginWiFi() ;
+
+    /*
+    * Work done in the background of the boot animation. Once the WiFi connection is up,
+    * this performs the first API request so that data is ready by the time the animation ends.
+    * Cancels the rest of the animation once data is ready if Config::skipBootDanceWhenReady is set.
+    */
+    void bootWork() ;
+
+    /*
+    * Pause used by the boot animation. Runs bootWork() while waiting during boot,
+    * and returns immediately once the animation has been cancelled.
+    *
+    * Parameters:
+    *   milliseconds: Time in milliseconds that the animation should pause for
+    */
+    void danceSleep(uint32_t milliseconds) ;
+
+    /*
+    * Record the current time for a boot phase if it has not been recorded already
+    *
+    * Parameters:
+    *   phase: The BootTimings field corresponding to the phase that was reached
+    */
+    void markBootPhase(uint32_t& phase) ;
+
 public:
 
     // Main constructor, also initializes hardware
@@ -136,6 +241,7 @@ public:
     
     /*
     * Wrapper for delay() function to clean up the style
+    * Display outputs keep moving towards their targets and metrics scrapes are answered while sleeping
     * 
     * Parameters:
     *   milliseconds: Time in milliseconds for the device to freeze and do nothing.
@@ -151,14 +257,45 @@ public:
     bool connectToWiFi() ;
 
     /*
-    * Calls API and requests data based on config
+    * Calls API and requests data from every endpoint in config, over one connection where possible.
+    * Each response is parsed as soon as it arrives
     * 
-    * Return: true if data is retrieved from API, else false
+    * Return: true if data is retrieved from every endpoint, else false
     */
     bool callAPI() ;
 
     /*
-    * Take retrieved value and update the servo arm display based on config
+    * Runs one full poll (connect to WiFi, call the API and parse the result) and
+    * reports the outcome to the retry scheduler. On failure, the last good value is kept.
+    *
+    * Return: true if a new value was retrieved, else false. Some values may be new
+    *   even if the poll as a whole failed
+    */
+    bool poll() ;
+
+    /*
+    * Check whether any of the displayed values is out of date (see Config::staleAfter)
+    *
+    * Return: true if a value is stale or has never been retrieved, else false
+    */
+    bool isStale() ;
+
+    /*
+    * Turn the action LED on while the circuit breaker is open or a value is stale,
+    * to show that the display may be out of date, and off otherwise
+    */
+    void updateActionLED() ;
+
+    /*
+    * Get the time to wait before the next poll, based on the results of previous polls
+    *
+    * Return: delay in milliseconds
+    */
+    uint32_t nextPollDelay() ;
+
+    /*
+    * Take retrieved values and update the servo arm and LED displays based on config
+    * Does not block; the outputs move into position during sleep()
     * 
     * Return: true if display is updated, else false
     */
@@ -167,17 +304,37 @@ public:
     /*
     * Parses locally stored payload if it is valid and finds desired data specified by the user in Config.h
     * 
-    * Return: true if the data was found, else false
+    * Parameters:
+    *   endpoint: Index into Config::APIEndpoints of the endpoint the payload came from.
+    *       Only the values taken from that endpoint are looked for
+    *
+    * Return: true if at least one of the values in Config::valueSources was found, else false
+    */
+    bool parseJson(uint8_t endpoint) ;
+
+    /*
+    * Finds desired data specified by the user in Config.h in a CBOR encoded response body
+    *
+    * Parameters:
+    *   endpoint: Index into Config::APIEndpoints of the endpoint the body came from.
+    *       Only the values taken from that endpoint are looked for
+    *   body: The response body
+    *
+    * Return: true if at least one of the values in Config::valueSources was found, else false
     */
-    bool parseJson() ;
+    bool parseCbor(uint8_t endpoint, const String& body) ;
 
     /*
     * Parses locally stored payload if it is valid and finds desired data specified by the user in Config.h
     * Manual parsing backup as a last resort for when ArduinoJson fails due to corruption of data
     * 
+    * Parameters:
+    *   key: The key whose value should be found
+    *   value: Set to the value found if successful, otherwise left unchanged
+    *
     * Return: true if the data was found, else false
     */
-    bool parseJson_manualFallback() ;
+    bool parseJson_manualFallback(const String& key, double& value) ;
 
     /*
     * Get the device's local IP address
@@ -207,6 +364,12 @@ public:
     void debugDance() ;
     void debugDance(uint16_t speed) ;
 
+    /*
+    * Print the time taken to reach each boot phase, measured from power-on.
+    * Time to first value is the metric to watch when changing the boot sequence.
+    */
+    void reportBootTimings() ;
+
 } ; // class Axon
 
 } // namespace ECG
@@ -0,0 +1,286 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "CborDecoder.h"
+
+using namespace ECG ;
+
+// Note: functions in this file should appear in the same order
+// as their declerations appear in their header.
+
+// CBOR major types
+const uint8_t CBOR_UNSIGNED = 0 ;
+const uint8_t CBOR_NEGATIVE = 1 ;
+const uint8_t CBOR_BYTES = 2 ;
+const uint8_t CBOR_TEXT = 3 ;
+const uint8_t CBOR_ARRAY = 4 ;
+const uint8_t CBOR_MAP = 5 ;
+const uint8_t CBOR_TAG = 6 ;
+const uint8_t CBOR_SIMPLE = 7 ;
+
+// Additional information values with special meanings
+const uint8_t CBOR_HALF_FLOAT = 25 ;
+const uint8_t CBOR_SINGLE_FLOAT = 26 ;
+const uint8_t CBOR_DOUBLE_FLOAT = 27 ;
+const uint8_t CBOR_INDEFINITE = 31 ;
+
+// Marks the end of an indefinite length item
+const uint8_t CBOR_BREAK = 0xff ;
+
+// Items nested deeper than this are treated as malformed
+const uint8_t CBOR_MAX_DEPTH = 16 ;
+
+// Converts an IEEE 754 half precision float, as in RFC 8949 appendix D
+static double halfToDouble(uint16_t half) {
+    int exponent = ( half >> 10 ) & 0x1f ;
+    int mantissa = half & 0x3ff ;
+
+    double value ;
+    if (exponent == 0) {
+        value = ldexp(mantissa, -24) ;
+    }
+    else
+    if (exponent != 31) {
+        value = ldexp(mantissa + 1024, exponent - 25) ;
+    }
+    else {
+        value = mantissa == 0 ? INFINITY : NAN ;
+    }
+
+    return ( half & 0x8000 ) ? -value : value ;
+}
+
+bool CborDecoder::readHead(uint8_t& major, uint8_t& info, uint64_t& argument) {
+
+    if (_pos >= _length) return false ;
+
+    uint8_t initial = _data[_pos++] ;
+    major = initial >> 5 ;
+    info = initial & 0x1f ;
+
+    // Case: the argument is in the initial byte itself
+    if (info < 24) {
+        argument = info ;
+        return true ;
+    }
+
+    // Case: indefinite length (only valid for strings, arrays and maps, or as a break)
+    if (info == CBOR_INDEFINITE) {
+        argument = 0 ;
+        return major == CBOR_BYTES || major == CBOR_TEXT || major == CBOR_ARRAY
+            || major == CBOR_MAP || initial == CBOR_BREAK ;
+    }
+
+    // Case: the argument follows in 1, 2, 4 or 8 bytes, most significant first
+    // 28 to 30 are reserved
+    if (info > 27) return false ;
+
+    uint8_t size = 1 << ( info - 24 ) ;
+    if (_length - _pos < size) return false ;
+
+    argument = 0 ;
+    for (uint8_t i = 0; i < size; i++) {
+        argument = ( argument << 8 ) | _data[_pos++] ;
+    }
+    return true ;
+}
+
+bool CborDecoder::skipItem(uint8_t depth) {
+
+    if (depth > CBOR_MAX_DEPTH) return false ;
+
+    uint8_t major, info ;
+    uint64_t argument ;
+    if (!readHead(major, info, argument)) return false ;
+
+    bool indefinite = info == CBOR_INDEFINITE ;
+
+    switch (major) {
+        // The head is the whole item
+        case CBOR_UNSIGNED:
+        case CBOR_NEGATIVE:
+        case CBOR_SIMPLE:
+            // A break here is not inside an indefinite length item
+            return !indefinite ;
+
+        // The argument is the number of bytes that follow
+        // Indefinite length strings are a series of definite length chunks ending with a break
+        case CBOR_BYTES:
+        case CBOR_TEXT:
+            if (indefinite) {
+                for (;;) {
+                    if (_pos >= _length) return false ;
+                    if (_data[_pos] == CBOR_BREAK) {
+                        _pos++ ;
+                        return true ;
+                    }
+                    if (!skipItem(depth + 1)) return false ;
+                }
+            }
+            if (argument > _length - _pos) return false ;
+            _pos += argument ;
+            return true ;
+
+        // The argument is the number of items (or pairs of items for a map) that follow
+        case CBOR_ARRAY:
+        case CBOR_MAP: {
+            if (indefinite) {
+                for (;;) {
+                    if (_pos >= _length) return false ;
+                    if (_data[_pos] == CBOR_BREAK) {
+                        _pos++ ;
+                        return true ;
+                    }
+                    if (!skipItem(depth + 1)) return false ;
+                    if (major == CBOR_MAP && !skipItem(depth + 1)) return false ;
+                }
+            }
+
+            // Every item is at least one byte, so a count larger than what is left can not be valid
+            if (argument > _length - _pos) return false ;
+            uint64_t items = major == CBOR_MAP ? argument * 2 : argument ;
+            for (uint64_t i = 0; i < items; i++) {
+                if (!skipItem(depth + 1)) return false ;
+            }
+            return true ;
+        }
+
+        // A tag is followed by the item it applies to
+        case CBOR_TAG:
+            return skipItem(depth + 1) ;
+    }
+
+    return false ;
+}
+
+bool CborDecoder::readNumber(double& value) {
+
+    uint8_t major, info ;
+    uint64_t argument ;
+
+    // Tags (e.g. for epoch times) do not change the number that follows, so they are passed over
+    do {
+        if (!readHead(major, info, argument)) return false ;
+    } while (major == CBOR_TAG) ;
+
+    switch (major) {
+        case CBOR_UNSIGNED:
+            value = (double) argument ;
+            return true ;
+
+        case CBOR_NEGATIVE:
+            value = -1.0 - (double) argument ;
+            return true ;
+
+        case CBOR_SIMPLE:
+            if (info == CBOR_HALF_FLOAT) {
+                value = halfToDouble((uint16_t) argument) ;
+                return true ;
+            }
+            if (info == CBOR_SINGLE_FLOAT) {
+                uint32_t bits = (uint32_t) argument ;
+                float single ;
+                memcpy(&single, &bits, sizeof(single)) ;
+                value = single ;
+                return true ;
+            }
+            if (info == CBOR_DOUBLE_FLOAT) {
+                memcpy(&value, &argument, sizeof(value)) ;
+                return true ;
+            }
+            return false ;
+    }
+
+    return false ;
+}
+
+CborDecoder::CborDecoder(const uint8_t* data, size_t length) {
+    _data = data ;
+    _length = length ;
+    _pos = 0 ;
+}
+
+uint8_t CborDecoder::findNumbers(const String* const keys[], uint8_t count, double values[], bool found[]) {
+
+    for (uint8_t k = 0; k < count; k++) {
+        found[k] = false ;
+    }
+
+    // Each search starts again from the top
+    _pos = 0 ;
+
+    uint8_t major, info ;
+    uint64_t pairs ;
+    if (!readHead(major, info, pairs) || major != CBOR_MAP) return 0 ;
+
+    bool indefinite = info == CBOR_INDEFINITE ;
+    uint8_t foundCount = 0 ;
+
+    for (uint64_t i = 0; ( indefinite || i < pairs ) && foundCount < count; i++) {
+
+        // An indefinite length map ends with a break
+        if (indefinite) {
+            if (_pos >= _length) break ;
+            if (_data[_pos] == CBOR_BREAK) break ;
+        }
+
+        // Compare the key in place if it is a definite length text string. Any other key is skipped
+        size_t keyStart = _pos ;
+        uint64_t keyLength ;
+        if (!readHead(major, info, keyLength)) break ;
+
+        int16_t match = -1 ;
+        if (major == CBOR_TEXT && info != CBOR_INDEFINITE) {
+            if (keyLength > _length - _pos) break ;
+            for (uint8_t k = 0; k < count; k++) {
+                if ( !found[k] && keyLength == keys[k]->length()
+                    && memcmp(_data + _pos, keys[k]->c_str(), keyLength) == 0 ) {
+                    match = k ;
+                    break ;
+                }
+            }
+            _pos += keyLength ;
+        }
+        else {
+            _pos = keyStart ;
+            if (!skipItem(0)) break ;
+        }
+
+        // A value that is not a number is skipped, and the key counts as not found
+        if (match >= 0) {
+            size_t valueStart = _pos ;
+            if (readNumber(values[match])) {
+                found[match] = true ;
+                foundCount++ ;
+                continue ;
+            }
+            _pos = valueStart ;
+        }
+
+        if (!skipItem(0)) break ;
+    }
+
+    return foundCount ;
+}
+
+bool CborDecoder::findNumber(const String& key, double& value) {
+    const String* keys[] = { &key } ;
+    bool found ;
+    return findNumbers(keys, 1, &value, &found) == 1 ;
+}
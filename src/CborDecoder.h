@@ -0,0 +1,114 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef CBOR_DECODER_H
+#define CBOR_DECODER_H
+
+#include <Arduino.h>
+
+namespace ECG {
+
+/*
+* Finds numeric values in a CBOR (RFC 8949) encoded response body
+*
+* The decoder works directly on the received bytes: keys are compared in place and numbers
+* are converted straight to doubles, so nothing is copied or allocated. Only the top level
+* map is searched, and everything else is skipped over without being decoded.
+*/
+class CborDecoder {
+
+private:
+
+    const uint8_t* _data ;
+    size_t _length ;
+
+    // Index of the next byte to be decoded
+    size_t _pos ;
+
+    /*
+    * Read the initial byte of an item and its argument
+    *
+    * Parameters:
+    *   major: Set to the major type (0 to 7)
+    *   info: Set to the additional information (the low 5 bits of the initial byte)
+    *   argument: Set to the argument (a length, count or value), or 0 for indefinite lengths
+    *
+    * Return: true if the head was read, false if the data is truncated or malformed
+    */
+    bool readHead(uint8_t& major, uint8_t& info, uint64_t& argument) ;
+
+    /*
+    * Skip over one complete item, including everything nested in it
+    *
+    * Parameters:
+    *   depth: How deeply nested the item is, to stop malicious data from overflowing the stack
+    *
+    * Return: true if the item was skipped, false if the data is truncated or malformed
+    */
+    bool skipItem(uint8_t depth) ;
+
+    /*
+    * Read a number (integer, half, single or double precision float) as a double
+    *
+    * Parameters:
+    *   value: Set to the number read
+    *
+    * Return: true if the next item is a number, else false
+    */
+    bool readNumber(double& value) ;
+
+public:
+
+    /*
+    * Parameters:
+    *   data: The encoded bytes. They must stay valid while the decoder is used
+    *   length: The number of bytes
+    */
+    CborDecoder(const uint8_t* data, size_t length) ;
+
+    /*
+    * Find the numeric values of several keys in the top level map, in a single pass over it.
+    * The search stops as soon as every key has been found
+    *
+    * Parameters:
+    *   keys: The text keys to look for
+    *   count: The number of keys
+    *   values: values[i] is set to the value of keys[i] if it is found, otherwise left unchanged
+    *   found: found[i] is set to true if keys[i] was found and its value is a number, else false
+    *
+    * Return: the number of keys found
+    */
+    uint8_t findNumbers(const String* const keys[], uint8_t count, double values[], bool found[]) ;
+
+    /*
+    * Find a numeric value in the top level map by its key
+    *
+    * Parameters:
+    *   key: The text key to look for
+    *   value: Set to the value found if successful, otherwise left unchanged
+    *
+    * Return: true if the key was found and its value is a number, else false
+    */
+    bool findNumber(const String& key, double& value) ;
+
+} ; // class CborDecoder
+
+} // namespace ECG
+
+#endif // CBOR_DECODER_H
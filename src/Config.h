@@ -19,6 +19,11 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <Arduino.h>
+
+// For the pin assignments
+#include "Options.h"
+
 namespace Config {
 
 
@@ -28,21 +33,91 @@ const String APIHost = "isenseproject.org" ;
 // The path the the version of the API to be targeted
 const String APIPath = "/api/v1" ;
 
-// The path to the particular endpoint to be targeted within the API
+// The paths to the particular endpoints to be targeted within the API
+// Values can be taken from any of them (see valueSources below)
 // /projects/2156 on the iSENSE API is Plinko!
-const String APIEndpoint = "/projects/2156" ;
+const String APIEndpoints[] = {
+    "/projects/2156"
+} ;
+const uint8_t APIEndpointCount = sizeof(APIEndpoints) / sizeof(APIEndpoints[0]) ;
+
+// If true, the requests for all endpoints are sent together over a single connection
+// (HTTP/1.1 pipelining) instead of waiting for each response before sending the next request.
+// If the server turns out not to support this, the device switches to one request at a time
+const bool usePipelining = true ;
+
+// If true, the device asks for responses in CBOR, a compact binary format that is much cheaper
+// to decode than JSON. Servers that do not support it send JSON as usual, which is still understood
+const bool requestBinaryFormat = true ;
 
 // Port to use in connection to API
 const uint16_t APIPort = 80 ;
 
+// Time limits in milliseconds for each phase of a request to the API. If any of them runs out,
+// the request is abandoned, the connection is closed and the poll is retried later.
+// A poll can take at most requestTimeout per endpoint in total, from the DNS lookup to the end of
+// the last response, including any reconnects
+const uint32_t connectTimeout = 3000 ;
+const uint32_t firstByteTimeout = 4000 ;
+const uint32_t headersTimeout = 2000 ;
+const uint32_t bodyTimeout = 4000 ;
+const uint32_t requestTimeout = 10000 ;
+
+// Largest response body in bytes that the device will accept
+const uint32_t maxPayloadSize = 4096 ;
+
+// Port on which the device serves its metrics in Prometheus text format,
+// e.g. curl http://<device IP>:9100/metrics
+const uint16_t metricsPort = 9100 ;
+
+// Time in milliseconds a client of the metrics endpoint has to send its request and receive
+// the response before it is dropped
+const uint32_t metricsRequestTimeout = 1000 ;
+
 /*
     TODO:
     -- add a way to specify the display method (linear, logarithmic, binary)
     -- add more display methods
 */
 
+// Describes a value to be retrieved from the API
+struct ValueSource {
+    String key ;         // The key of the value in the response
+    uint8_t endpoint ;   // Index into APIEndpoints of the endpoint whose response contains the value
+} ;
+
+// The values to be retrieved from the API. Each output channel below
+// displays one of these values, selected by its index in this list.
 // FIXME: This may not be the best way to do this
-const String targetKey = "dataSetCount" ;
+const ValueSource valueSources[] = {
+    { "dataSetCount", 0 }
+} ;
+const uint8_t valueSourceCount = sizeof(valueSources) / sizeof(valueSources[0]) ;
+
+// The kinds of output that can be used to display a value
+enum ChannelType {
+    CHANNEL_SERVO,          // A servo arm. Its angle shows where the value is in the channel's range
+    CHANNEL_PWM_LED,        // An LED whose brightness shows where the value is in the channel's range
+    CHANNEL_THRESHOLD_LED   // An LED that turns on once the value reaches the high bound,
+                            // and back off once it falls to the low bound
+} ;
+
+// What a channel shows about its value. The channel's bounds are in the units of the mode
+enum DisplayMode {
+    DISPLAY_ABSOLUTE,    // The most recently retrieved value
+    DISPLAY_SMOOTHED,    // A moving average of the retrieved values (see ewmaWeight)
+    DISPLAY_RATE         // How fast the value is changing, in units per minute
+} ;
+
+// Describes one display output and the value it shows
+struct OutputChannel {
+    ChannelType type ;
+    uint8_t pin ;        // GPIO pin the output is connected to. LEDs are expected to be active high
+    uint8_t source ;     // Index into valueSources of the value to display
+    DisplayMode mode ;
+    double lowBound ;    // See displayLowBound below
+    double highBound ;   // See displayHighBound below
+} ;
 
 // The expected range of the retrieved value. The servo arm will be adjusted to show how far
 // the retrieved values is between these values. If the value is outside this range, the servo
@@ -50,6 +125,55 @@ const String targetKey = "dataSetCount" ;
 const double displayLowBound = 1600;
 const double displayHighBound = 1700.0 ;
 
+// The outputs attached to the device. All of them are updated together, so adding channels
+// does not make the display any slower to respond
+const OutputChannel outputChannels[] = {
+    { CHANNEL_SERVO, SERVO_PIN, 0, DISPLAY_ABSOLUTE, displayLowBound, displayHighBound }
+} ;
+const uint8_t outputChannelCount = sizeof(outputChannels) / sizeof(outputChannels[0]) ;
+
+// The number of recent samples of each value kept on the device. Rates of change, minimums
+// and maximums are taken over this many samples. Each sample uses 16 bytes of RAM, plus
+// 8 more for tracking the minimum and maximum
+const uint16_t historySize = 32 ;
+
+// Weight given to each new sample in the moving average used by DISPLAY_SMOOTHED, between 0 and 1.
+// Smaller values smooth out more noise but respond to real changes more slowly
+const double ewmaWeight = 0.2 ;
+
+// A value that has not been successfully retrieved for this many milliseconds is considered stale
+const uint32_t staleAfter = 600000 ;
+
+// If true, the boot animation is cut short as soon as the first value has been retrieved,
+// so the display shows real data as early as possible
+const bool skipBootDanceWhenReady = true ;
+
+// The last values and display positions are saved so that they can be shown again as soon as
+// the device reboots. If this is true, the boot animation is skipped when they are restored,
+// so that it does not move the arms away from the restored positions
+const bool skipBootDanceWhenRestored = true ;
+
+// Minimum time in milliseconds between saves of the display state to flash, which wears out
+// with repeated writes. Saves are also skipped when nothing has changed. RTC memory, which
+// survives resets but not loss of power, is updated on every change regardless
+const uint32_t flashSaveInterval = 1800000 ;
+
+// Time in milliseconds between polls of the API while everything is working
+const uint32_t pollInterval = 5000 ;
+
+// After a transient failure, the device waits retryBaseDelay before retrying, doubling the wait
+// after each further failure up to retryMaxDelay. Half of each wait is randomized.
+const uint32_t retryBaseDelay = 2000 ;
+const uint32_t retryMaxDelay = 60000 ;
+
+// After this many consecutive failures the circuit breaker opens and the device stops retrying
+// quickly. It keeps showing the last good value and probes the API every circuitProbeInterval
+// milliseconds until a poll succeeds. Permanent failures (404, unparsable data) open the circuit
+// immediately and are probed every permanentFailureProbeInterval milliseconds instead.
+const uint16_t circuitBreakerThreshold = 5 ;
+const uint32_t circuitProbeInterval = 120000 ;
+const uint32_t permanentFailureProbeInterval = 600000 ;
+
 } // namespace Config
 
 #endif // CONFIG_H
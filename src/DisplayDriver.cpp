@@ -0,0 +1,218 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "DisplayDriver.h"
+
+// For SHOW_SERVO_MOVES
+#include "Options.h"
+
+using namespace ECG ;
+
+// Note: functions in this file should appear in the same order
+// as their declerations appear in their header.
+
+// Number of brightness levels used for PWM LED channels
+const uint16_t PWM_LEVELS = 1023 ;
+
+// Speed in degrees per second at which servo channels move to show a new value
+const uint16_t DISPLAY_SERVO_SPEED = 90 ;
+
+double DisplayDriver::valueFor(uint8_t channel, const SourceHistory& history) {
+
+    // All of these are kept up to date as samples are added, so none of them scan the history
+    switch (Config::outputChannels[channel].mode) {
+        case Config::DISPLAY_ABSOLUTE:
+            return history.latest() ;
+
+        case Config::DISPLAY_SMOOTHED:
+            return history.ewma() ;
+
+        case Config::DISPLAY_RATE:
+            return history.deltaPerMinute() ;
+    }
+
+    return history.latest() ;
+}
+
+uint16_t DisplayDriver::targetFor(uint8_t channel, double value) {
+
+    const Config::OutputChannel& config = Config::outputChannels[channel] ;
+
+    // How far the value is between the bounds, from 0 to 1
+    double fraction ;
+    if (value <= config.lowBound) {
+        fraction = 0.0 ;
+    }
+    else
+    if (value >= config.highBound) {
+        fraction = 1.0 ;
+    }
+    else {
+        fraction = ( value - config.lowBound ) / ( config.highBound - config.lowBound ) ;
+    }
+
+    switch (config.type) {
+        case Config::CHANNEL_SERVO:
+            return (uint16_t) round(180.0 * fraction) ;
+
+        case Config::CHANNEL_PWM_LED:
+            return (uint16_t) round(PWM_LEVELS * fraction) ;
+
+        case Config::CHANNEL_THRESHOLD_LED:
+            // Between the bounds, the LED keeps its current state so that it does not flicker
+            // when the value hovers around a single threshold
+            if (value >= config.highBound) return 1 ;
+            if (value <= config.lowBound) return 0 ;
+            return _channels[channel].target ;
+    }
+
+    return 0 ;
+}
+
+void DisplayDriver::writeOutput(uint8_t channel) {
+
+    ChannelState& state = _channels[channel] ;
+    const Config::OutputChannel& config = Config::outputChannels[channel] ;
+
+    switch (config.type) {
+        case Config::CHANNEL_SERVO:
+            state.servo.write(state.current) ;
+            break ;
+
+        case Config::CHANNEL_PWM_LED:
+            analogWrite(config.pin, state.current) ;
+            break ;
+
+        case Config::CHANNEL_THRESHOLD_LED:
+            digitalWrite(config.pin, state.current ? HIGH : LOW) ;
+            break ;
+    }
+}
+
+DisplayDriver::DisplayDriver() {
+    for (uint8_t i = 0; i < Config::outputChannelCount; i++) {
+        _channels[i].target = 0 ;
+        _channels[i].current = 0 ;
+        _channels[i].lastStep = 0 ;
+        _channels[i].stepInterval = 1000 / DISPLAY_SERVO_SPEED ;
+    }
+}
+
+void DisplayDriver::begin(uint16_t initialAngle) {
+
+    analogWriteRange(PWM_LEVELS) ;
+
+    for (uint8_t i = 0; i < Config::outputChannelCount; i++) {
+        ChannelState& state = _channels[i] ;
+        const Config::OutputChannel& config = Config::outputChannels[i] ;
+
+        if (config.type == Config::CHANNEL_SERVO) {
+            state.servo.attach(config.pin) ;
+            state.current = initialAngle % 181 ;
+        }
+        else {
+            pinMode(config.pin, OUTPUT) ;
+            state.current = 0 ;
+        }
+
+        state.target = state.current ;
+        writeOutput(i) ;
+    }
+}
+
+void DisplayDriver::setValue(uint8_t source, const SourceHistory& history) {
+
+    for (uint8_t i = 0; i < Config::outputChannelCount; i++) {
+        if (Config::outputChannels[i].source != source) continue ;
+
+        ChannelState& state = _channels[i] ;
+        state.target = targetFor(i, valueFor(i, history)) ;
+        state.stepInterval = 1000 / DISPLAY_SERVO_SPEED ;
+
+        if (SHOW_SERVO_MOVES && Config::outputChannels[i].type == Config::CHANNEL_SERVO) {
+            Serial.printf("Channel %d: begin move to angle %d\n", i, state.target) ;
+        }
+
+        // LEDs have no moving parts, so they can be set straight away
+        if (Config::outputChannels[i].type != Config::CHANNEL_SERVO) {
+            state.current = state.target ;
+            writeOutput(i) ;
+        }
+    }
+}
+
+void DisplayDriver::setServoTargets(uint16_t angle, uint16_t speed) {
+
+    // Avoid dividing by zero below
+    if (speed < 1) speed = 1 ;
+
+    for (uint8_t i = 0; i < Config::outputChannelCount; i++) {
+        if (Config::outputChannels[i].type != Config::CHANNEL_SERVO) continue ;
+
+        _channels[i].target = angle % 181 ;
+        _channels[i].stepInterval = (uint16_t) round(1000.0 / speed) ;
+    }
+}
+
+void DisplayDriver::setPosition(uint8_t channel, uint16_t position) {
+
+    ChannelState& state = _channels[channel] ;
+
+    // Keep the position in range for the channel's type, in case it came from an old config
+    switch (Config::outputChannels[channel].type) {
+        case Config::CHANNEL_SERVO:         position = position % 181 ; break ;
+        case Config::CHANNEL_PWM_LED:       if (position > PWM_LEVELS) position = PWM_LEVELS ; break ;
+        case Config::CHANNEL_THRESHOLD_LED: position = position ? 1 : 0 ; break ;
+    }
+
+    state.current = position ;
+    state.target = position ;
+    writeOutput(channel) ;
+}
+
+uint16_t DisplayDriver::position(uint8_t channel) {
+    return _channels[channel].target ;
+}
+
+bool DisplayDriver::tick() {
+
+    uint32_t now = millis() ;
+    bool moving = false ;
+
+    for (uint8_t i = 0; i < Config::outputChannelCount; i++) {
+        ChannelState& state = _channels[i] ;
+
+        if (state.current == state.target) continue ;
+        moving = true ;
+
+        // Each servo moves one degree per step, at its own pace
+        if (now - state.lastStep < state.stepInterval) continue ;
+        state.lastStep = now ;
+
+        if (state.current < state.target) {
+            state.current++ ;
+        }
+        else {
+            state.current-- ;
+        }
+        writeOutput(i) ;
+    }
+
+    return moving ;
+}
@@ -0,0 +1,145 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef DISPLAY_DRIVER_H
+#define DISPLAY_DRIVER_H
+
+#include <Arduino.h>
+#include <Servo.h>
+
+#include "Config.h"
+#include "ValueHistory.h"
+
+namespace ECG {
+
+class DisplayDriver {
+
+private:
+
+    // Runtime state of each entry in Config::outputChannels
+    struct ChannelState {
+        // Only used by CHANNEL_SERVO channels
+        Servo servo ;
+
+        // Position the output is moving towards, and where it is now.
+        // Servo angles are in degrees, PWM LED levels are out of PWM_LEVELS, threshold LEDs are 0 or 1
+        uint16_t target ;
+        uint16_t current ;
+
+        // Servo channels step one degree every stepInterval milliseconds
+        uint32_t lastStep ;
+        uint16_t stepInterval ;
+    } ;
+
+    ChannelState _channels[Config::outputChannelCount] ;
+
+    /*
+    * Pick the quantity a channel shows from the history of its value, according to its display mode
+    *
+    * Parameters:
+    *   channel: Index of the channel in Config::outputChannels
+    *   history: The samples of the channel's value
+    *
+    * Return: the quantity to be displayed, in the units of the channel's bounds
+    */
+    double valueFor(uint8_t channel, const SourceHistory& history) ;
+
+    /*
+    * Calculate the output position for a value according to a channel's type and range
+    *
+    * Parameters:
+    *   channel: Index of the channel in Config::outputChannels
+    *   value: The value to be displayed
+    *
+    * Return: the target position for the channel (see ChannelState)
+    */
+    uint16_t targetFor(uint8_t channel, double value) ;
+
+    /*
+    * Write a channel's current position to its hardware
+    *
+    * Parameters:
+    *   channel: Index of the channel in Config::outputChannels
+    */
+    void writeOutput(uint8_t channel) ;
+
+public:
+
+    DisplayDriver() ;
+
+    /*
+    * Attach every output in Config::outputChannels. Servos are moved straight to the given angle
+    * and LEDs are switched off.
+    *
+    * Parameters:
+    *   initialAngle: The angle servos start at
+    */
+    void begin(uint16_t initialAngle) ;
+
+    /*
+    * Show a new value on every channel bound to a value source. Returns immediately,
+    * servos then move towards their new position as tick() is called.
+    *
+    * Parameters:
+    *   source: Index into Config::valueSources of the value that changed
+    *   history: The samples of that value, including the new one
+    */
+    void setValue(uint8_t source, const SourceHistory& history) ;
+
+    /*
+    * Point every servo channel at the same angle, regardless of its value. Used for animations.
+    *
+    * Parameters:
+    *   angle: Angle between 0 and 180 to move to
+    *   speed: Speed of the movement in degrees per second
+    */
+    void setServoTargets(uint16_t angle, uint16_t speed) ;
+
+    /*
+    * Move a channel straight to a position without stepping, e.g. to restore it after a reboot
+    *
+    * Parameters:
+    *   channel: Index of the channel in Config::outputChannels
+    *   position: The position to move to (see ChannelState)
+    */
+    void setPosition(uint8_t channel, uint16_t position) ;
+
+    /*
+    * Get the position a channel is at or moving to
+    *
+    * Parameters:
+    *   channel: Index of the channel in Config::outputChannels
+    *
+    * Return: the channel's target position (see ChannelState)
+    */
+    uint16_t position(uint8_t channel) ;
+
+    /*
+    * Advance every output one step towards its target if its step is due. Never blocks,
+    * so it should be called as often as possible.
+    *
+    * Return: true if any output is still moving, else false
+    */
+    bool tick() ;
+
+} ; // class DisplayDriver
+
+} // namespace ECG
+
+#endif // DISPLAY_DRIVER_H
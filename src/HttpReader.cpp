@@ -0,0 +1,356 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "HttpReader.h"
+
+#include <ESP8266WiFi.h>
+
+#include "Config.h"
+
+// For SHOW_HTTP_HEADERS
+#include "Options.h"
+
+using namespace ECG ;
+
+// Note: functions in this file should appear in the same order
+// as their declerations appear in their header.
+
+// Lines longer than this are not part of any response the device expects
+const uint16_t MAX_LINE_LENGTH = 512 ;
+
+uint32_t HttpReader::remaining() {
+
+    uint32_t now = millis() ;
+
+    uint32_t phaseBudget ;
+    switch (_phase) {
+        case PHASE_CONNECT:    phaseBudget = Config::connectTimeout ; break ;
+        case PHASE_FIRST_BYTE: phaseBudget = Config::firstByteTimeout ; break ;
+        case PHASE_HEADERS:    phaseBudget = Config::headersTimeout ; break ;
+        default:               phaseBudget = Config::bodyTimeout ; break ;
+    }
+
+    // Whichever of the phase and poll deadlines comes first
+    uint32_t phaseElapsed = now - _phaseStart ;
+    uint32_t pollElapsed = now - _start ;
+    uint32_t phaseLeft = phaseElapsed >= phaseBudget ? 0 : phaseBudget - phaseElapsed ;
+    uint32_t pollLeft = pollElapsed >= _budget ? 0 : _budget - pollElapsed ;
+
+    return phaseLeft < pollLeft ? phaseLeft : pollLeft ;
+}
+
+bool HttpReader::expired() {
+    return remaining() == 0 ;
+}
+
+int HttpReader::readByte() {
+
+    for (;;) {
+        // Data that has already arrived can be read even if the server has since closed the connection
+        if (_client.available() > 0) {
+            return _client.read() ;
+        }
+
+        if (!_client.connected() && _client.available() <= 0) {
+            _result = HTTP_CLOSED ;
+            return -1 ;
+        }
+
+        if (expired()) {
+            _result = HTTP_TIMEOUT ;
+            return -1 ;
+        }
+
+        // Let the WiFi stack run while waiting for more data
+        delay(1) ;
+    }
+}
+
+bool HttpReader::readLine(String& line) {
+
+    line = "" ;
+
+    for (;;) {
+        int c = readByte() ;
+        if (c < 0) return false ;
+
+        if (c == '\n') break ;
+        if (c != '\r') line += (char) c ;
+
+        if (line.length() > MAX_LINE_LENGTH) {
+            _result = HTTP_MALFORMED ;
+            return false ;
+        }
+    }
+
+    if (SHOW_HTTP_HEADERS && _phase != PHASE_BODY) {
+        Serial.printf("%s\n", line.c_str()) ;
+    }
+
+    return true ;
+}
+
+bool HttpReader::readBody(HttpResponse& response) {
+
+    response.body = "" ;
+
+    // Case: chunked encoding
+    // Each chunk is preceeded by its length in hex on its own line, and the body ends with a chunk of length 0
+    if (response.chunked) {
+        String line ;
+        for (;;) {
+            if (!readLine(line)) return false ;
+            uint32_t chunkLength = strtoul(line.c_str(), nullptr, 16) ;
+
+            // The last chunk is followed by optional trailers and then an empty line
+            if (chunkLength == 0) {
+                do {
+                    if (!readLine(line)) return false ;
+                } while (line.length() > 0) ;
+                return true ;
+            }
+
+            if (response.body.length() + chunkLength > Config::maxPayloadSize) {
+                _result = HTTP_MALFORMED ;
+                return false ;
+            }
+
+            response.body.reserve(response.body.length() + chunkLength) ;
+            for (uint32_t i = 0; i < chunkLength; i++) {
+                int c = readByte() ;
+                if (c < 0) return false ;
+                response.body += (char) c ;
+            }
+
+            // Each chunk ends with "\r\n"
+            if (!readLine(line)) return false ;
+        }
+    }
+
+    // Case: known length
+    if (response.contentLength >= 0) {
+        if ((uint32_t) response.contentLength > Config::maxPayloadSize) {
+            _result = HTTP_MALFORMED ;
+            return false ;
+        }
+
+        response.body.reserve(response.contentLength) ;
+        for (int32_t i = 0; i < response.contentLength; i++) {
+            int c = readByte() ;
+            if (c < 0) return false ;
+            response.body += (char) c ;
+        }
+        return true ;
+    }
+
+    // Case: no framing, so the body lasts until the server closes the connection
+    for (;;) {
+        int c = readByte() ;
+        if (c < 0) return _result == HTTP_CLOSED ;
+
+        if (response.body.length() >= Config::maxPayloadSize) {
+            _result = HTTP_MALFORMED ;
+            return false ;
+        }
+        response.body += (char) c ;
+    }
+}
+
+bool HttpReader::fail(HttpResult result) {
+    _result = result ;
+    _client.stop() ;
+    return false ;
+}
+
+HttpReader::HttpReader(WiFiClient& client) : _client(client) {
+    start(Config::requestTimeout) ;
+}
+
+void HttpReader::start(uint32_t budget) {
+    _start = millis() ;
+    _phaseStart = _start ;
+    _budget = budget ;
+    _phase = PHASE_CONNECT ;
+    _result = HTTP_OK ;
+}
+
+void HttpReader::beginPhase(HttpPhase phase) {
+    _phase = phase ;
+    _phaseStart = millis() ;
+}
+
+bool HttpReader::connect(const String& host, uint16_t port) {
+
+    beginPhase(PHASE_CONNECT) ;
+
+    // Look up the host first, so that the DNS lookup is bounded by the connect budget
+    // rather than by the WiFi library's own timeout
+    IPAddress address ;
+    if ( !WiFi.hostByName(host.c_str(), address, remaining()) ) {
+        // Tell a timeout apart from a failed lookup
+        return fail(expired() ? HTTP_TIMEOUT : HTTP_CLOSED) ;
+    }
+
+    if (expired()) {
+        return fail(HTTP_TIMEOUT) ;
+    }
+
+    // The client gives up on connecting after its stream timeout, so it is set to what is left of the budget
+    _client.setTimeout(remaining()) ;
+
+    if ( !_client.connect(address, port) ) {
+        // Tell a timeout apart from an outright refusal
+        return fail(expired() ? HTTP_TIMEOUT : HTTP_CLOSED) ;
+    }
+
+    // Send each request as soon as it is written. Otherwise requests pipelined after the first
+    // would be held back until the server acknowledged it, a whole round trip later
+    _client.setNoDelay(true) ;
+
+    if (expired()) {
+        return fail(HTTP_TIMEOUT) ;
+    }
+
+    _result = HTTP_OK ;
+    return true ;
+}
+
+bool HttpReader::send(const String& request) {
+
+    beginPhase(PHASE_FIRST_BYTE) ;
+    if (expired()) {
+        return fail(HTTP_TIMEOUT) ;
+    }
+
+    // The client waits up to its stream timeout for room in its send buffer,
+    // so it is set to what is left of the budget
+    _client.setTimeout(remaining()) ;
+
+    if ( _client.print(request) < request.length() ) {
+        // Tell a timeout apart from a closed connection
+        return fail(expired() ? HTTP_TIMEOUT : HTTP_CLOSED) ;
+    }
+
+    _result = HTTP_OK ;
+    return true ;
+}
+
+bool HttpReader::readResponse(HttpResponse& response) {
+
+    response.status = 0 ;
+    response.contentType = "" ;
+    response.contentLength = -1 ;
+    response.chunked = false ;
+    response.keepAlive = false ;
+    response.body = "" ;
+    _result = HTTP_OK ;
+
+    if (SHOW_HTTP_HEADERS) {
+        Serial.printf("RESPONSE FOLLOWS\n") ;
+    }
+
+    // Wait for the server to start responding
+    beginPhase(PHASE_FIRST_BYTE) ;
+    int first = readByte() ;
+    if (first < 0) return fail(_result) ;
+
+    // The rest of the status line and the headers share the header budget
+    beginPhase(PHASE_HEADERS) ;
+    String line ;
+    if (!readLine(line)) return fail(_result) ;
+    line = String((char) first) + line ;
+
+    // The status line looks like "HTTP/1.1 200 OK". The response code is always in the same place
+    const uint8_t indexOfResponseSubstring = String("HTTP/1.1 ").length() ;
+    if (!line.startsWith("HTTP/1.") || line.length() < (uint16_t) (indexOfResponseSubstring + 3)) {
+        return fail(HTTP_MALFORMED) ;
+    }
+    response.status = line.substring(indexOfResponseSubstring, indexOfResponseSubstring + 3).toInt() ;
+
+    // HTTP/1.1 connections stay open unless the server says otherwise, HTTP/1.0 ones do not
+    response.keepAlive = line.charAt(7) == '1' ;
+
+    // Headers end with an empty line
+    for (;;) {
+        if (!readLine(line)) return fail(_result) ;
+        if (line.length() == 0) break ;
+
+        int colon = line.indexOf(':') ;
+        if (colon < 0) continue ;
+
+        String name = line.substring(0, colon) ;
+        String value = line.substring(colon + 1) ;
+        name.trim() ;
+        value.trim() ;
+        name.toLowerCase() ;
+
+        if (name == "content-length") {
+            response.contentLength = value.toInt() ;
+        }
+        else
+        if (name == "transfer-encoding") {
+            value.toLowerCase() ;
+            response.chunked = value.indexOf("chunked") >= 0 ;
+        }
+        else
+        if (name == "connection") {
+            value.toLowerCase() ;
+            if (value.indexOf("close") >= 0) response.keepAlive = false ;
+            if (value.indexOf("keep-alive") >= 0) response.keepAlive = true ;
+        }
+        else
+        if (name == "content-type") {
+            value.toLowerCase() ;
+            response.contentType = value ;
+        }
+    }
+
+    beginPhase(PHASE_BODY) ;
+    if (!readBody(response)) return fail(_result) ;
+
+    // Without a length or chunking, the end of the body is the end of the connection
+    if (!response.chunked && response.contentLength < 0) {
+        response.keepAlive = false ;
+    }
+
+    _result = HTTP_OK ;
+    return true ;
+}
+
+HttpResult HttpReader::result() {
+    return _result ;
+}
+
+HttpPhase HttpReader::phase() {
+    return _phase ;
+}
+
+uint32_t HttpReader::elapsed() {
+    return millis() - _start ;
+}
+
+const char* HttpReader::phaseName(HttpPhase phase) {
+    switch (phase) {
+        case PHASE_CONNECT:    return "connect" ;
+        case PHASE_FIRST_BYTE: return "first byte" ;
+        case PHASE_HEADERS:    return "headers" ;
+        case PHASE_BODY:       return "body" ;
+    }
+    return "unknown" ;
+}
@@ -0,0 +1,210 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HTTP_READER_H
+#define HTTP_READER_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+namespace ECG {
+
+// The phases of an HTTP request, each of which has its own time budget in Config.h
+enum HttpPhase {
+    PHASE_CONNECT,
+    PHASE_FIRST_BYTE,
+    PHASE_HEADERS,
+    PHASE_BODY
+} ;
+
+// Outcome of reading from the server
+enum HttpResult {
+    HTTP_OK,
+    HTTP_TIMEOUT,    // A phase ran out of time, or the poll as a whole did
+    HTTP_CLOSED,     // The server closed the connection before the response was complete
+    HTTP_MALFORMED   // The response could not be understood, or was too large
+} ;
+
+// A response read by HttpReader
+struct HttpResponse {
+    uint16_t status ;
+    String contentType ;     // Lower-cased, as media types are case-insensitive
+    int32_t contentLength ;  // -1 if the server did not send a Content-Length header
+    bool chunked ;           // true if the body uses chunked transfer encoding
+    bool keepAlive ;         // true if the server will keep the connection open after this response
+    String body ;            // The body, with any chunked encoding removed
+} ;
+
+/*
+* Reads HTTP responses from a WiFiClient without ever waiting past a deadline
+*
+* Every step is bounded by the budget of the current phase and by one deadline for the poll
+* as a whole (see Config.h). That deadline covers the DNS lookup, connecting, sending, reading
+* and any reconnects, so a slow, trickling or half-open server can only hold up a poll for a
+* fixed amount of time. When a budget runs out, the connection is closed straight away.
+*/
+class HttpReader {
+
+private:
+
+    WiFiClient& _client ;
+
+    // millis() when the poll and the current phase began, and the time allowed for the whole poll
+    uint32_t _start ;
+    uint32_t _phaseStart ;
+    uint32_t _budget ;
+
+    HttpPhase _phase ;
+    HttpResult _result ;
+
+    /*
+    * Get the time left before the current phase or the poll as a whole runs out of time
+    *
+    * Return: the time left in milliseconds, or 0 if either deadline has passed
+    */
+    uint32_t remaining() ;
+
+    /*
+    * Check whether the current phase or the poll as a whole has run out of time
+    *
+    * Return: true if either deadline has passed, else false
+    */
+    bool expired() ;
+
+    /*
+    * Wait for and read a single byte from the server
+    *
+    * Return: the byte read, or -1 if the deadline passed or the connection closed (see result())
+    */
+    int readByte() ;
+
+    /*
+    * Read a line from the server, without its trailing "\r\n"
+    *
+    * Parameters:
+    *   line: Set to the line read
+    *
+    * Return: true if a complete line was read, else false (see result())
+    */
+    bool readLine(String& line) ;
+
+    /*
+    * Read a response body according to its framing (Content-Length, chunked, or until close)
+    *
+    * Parameters:
+    *   response: The response whose headers have been read. Its body is filled in
+    *
+    * Return: true if the whole body was read, else false (see result())
+    */
+    bool readBody(HttpResponse& response) ;
+
+    /*
+    * Record a failure and close the connection
+    *
+    * Parameters:
+    *   result: The reason for the failure
+    *
+    * Return: always false, for convenience
+    */
+    bool fail(HttpResult result) ;
+
+public:
+
+    /*
+    * Parameters:
+    *   client: The client used to talk to the server
+    */
+    HttpReader(WiFiClient& client) ;
+
+    /*
+    * Start timing a poll. Everything done from here on, for every request of the poll,
+    * must be finished within the budget
+    *
+    * Parameters:
+    *   budget: The time allowed for the whole poll, in milliseconds
+    */
+    void start(uint32_t budget) ;
+
+    /*
+    * Start a new phase of the request, with a fresh phase budget
+    *
+    * Parameters:
+    *   phase: The phase that is starting
+    */
+    void beginPhase(HttpPhase phase) ;
+
+    /*
+    * Connect to a server within the connect budget
+    *
+    * Parameters:
+    *   host: The domain name of the server
+    *   port: The port to connect to
+    *
+    * Return: true if the connection was made in time, else false
+    */
+    bool connect(const String& host, uint16_t port) ;
+
+    /*
+    * Send a request to the server. Sending counts towards the first byte budget,
+    * as the server can not start answering until it has the request
+    *
+    * Parameters:
+    *   request: The complete request
+    *
+    * Return: true if all of the request was sent in time, else false
+    */
+    bool send(const String& request) ;
+
+    /*
+    * Read a complete response (status line, headers and body) from the server
+    *
+    * Parameters:
+    *   response: Filled in with the response
+    *
+    * Return: true if the response was read in full, else false (see result())
+    */
+    bool readResponse(HttpResponse& response) ;
+
+    /*
+    * Return: the outcome of the last operation
+    */
+    HttpResult result() ;
+
+    /*
+    * Return: the phase that was in progress when the last operation finished
+    */
+    HttpPhase phase() ;
+
+    /*
+    * Return: the time in milliseconds since the poll started
+    */
+    uint32_t elapsed() ;
+
+    /*
+    * Get a human readable name for a phase, for debug output
+    *
+    * Return: a short string naming the phase
+    */
+    static const char* phaseName(HttpPhase phase) ;
+
+} ; // class HttpReader
+
+} // namespace ECG
+
+#endif // HTTP_READER_H
@@ -0,0 +1,344 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "MetricsServer.h"
+
+#include <float.h>
+#include <stdarg.h>
+
+using namespace ECG ;
+
+// Note: functions in this file should appear in the same order
+// as their declerations appear in their header.
+
+void MetricsServer::clear(Text& text) {
+    text.length = 0 ;
+    text.needed = 0 ;
+    text.buffer[0] = '\0' ;
+}
+
+void MetricsServer::append(Text& text, const char* format, ...) {
+
+    va_list args ;
+    va_start(args, format) ;
+    int written = vsnprintf(text.buffer + text.length, text.size - text.length, format, args) ;
+    va_end(args) ;
+    if (written < 0) return ;
+
+    // Once something has been left out, nothing more is added. Otherwise a sample could be
+    // sent without the HELP and TYPE lines it belongs to
+    bool fitted = text.needed == text.length ;
+    text.needed += written ;
+    if (fitted && text.needed < text.size) {
+        text.length = text.needed ;
+        return ;
+    }
+
+    text.buffer[text.length] = '\0' ;
+    if (fitted) {
+        Serial.printf("Metrics text does not fit in its %u byte buffer! Leaving out the rest.\n", text.size) ;
+    }
+}
+
+void MetricsServer::formatBody(const PollMetrics& metrics, const SourceHistory* history) {
+
+    // Uptime, heap, WiFi signal and the age of each value are left to formatLive(), as they change between polls
+
+    clear(_body) ;
+
+    append(_body,
+           "# HELP axon_polls_total Polls of the API since boot.\n"
+           "# TYPE axon_polls_total counter\n"
+           "axon_polls_total %u\n", metrics.polls) ;
+
+    append(_body,
+           "# HELP axon_poll_successes_total Polls that retrieved a new value.\n"
+           "# TYPE axon_poll_successes_total counter\n"
+           "axon_poll_successes_total %u\n", metrics.successes) ;
+
+    append(_body,
+           "# HELP axon_poll_failures_total Failed polls by cause.\n"
+           "# TYPE axon_poll_failures_total counter\n") ;
+    for (uint8_t i = FAILURE_NONE + 1; i < FAILURE_CAUSE_COUNT; i++) {
+        append(_body,
+            "axon_poll_failures_total{cause=\"%s\"} %u\n",
+            RetryScheduler::causeName((FailureCause) i), metrics.failures[i]) ;
+    }
+
+    append(_body,
+           "# HELP axon_last_request_milliseconds Time taken to fetch every endpoint on the most recent poll.\n"
+           "# TYPE axon_last_request_milliseconds gauge\n"
+           "axon_last_request_milliseconds %u\n", metrics.lastRequestMs) ;
+
+    append(_body,
+           "# HELP axon_worst_request_milliseconds Longest time taken to fetch every endpoint on any poll.\n"
+           "# TYPE axon_worst_request_milliseconds gauge\n"
+           "axon_worst_request_milliseconds %u\n", metrics.worstRequestMs) ;
+
+    append(_body,
+           "# HELP axon_last_parse_microseconds Time taken to parse the payloads of the most recent poll.\n"
+           "# TYPE axon_last_parse_microseconds gauge\n"
+           "axon_last_parse_microseconds %u\n", metrics.lastParseUs) ;
+
+    append(_body,
+           "# HELP axon_last_payload_bytes Size of the payloads of the most recent poll.\n"
+           "# TYPE axon_last_payload_bytes gauge\n"
+           "axon_last_payload_bytes %u\n", metrics.lastPayloadBytes) ;
+
+    append(_body,
+           "# HELP axon_responses_total Successful responses by encoding.\n"
+           "# TYPE axon_responses_total counter\n"
+           "axon_responses_total{format=\"cbor\"} %u\n"
+           "axon_responses_total{format=\"json\"} %u\n", metrics.cborResponses, metrics.jsonResponses) ;
+
+    append(_body,
+           "# HELP axon_circuit_open Whether the circuit breaker is open.\n"
+           "# TYPE axon_circuit_open gauge\n"
+           "axon_circuit_open %d\n", metrics.circuitOpen ? 1 : 0) ;
+
+    append(_body,
+           "# HELP axon_mean_time_to_recovery_milliseconds Mean length of outages since boot.\n"
+           "# TYPE axon_mean_time_to_recovery_milliseconds gauge\n"
+           "axon_mean_time_to_recovery_milliseconds %u\n", metrics.meanTimeToRecoveryMs) ;
+
+    append(_body,
+           "# HELP axon_wifi_reconnects_total Times the WiFi connection came back after being lost.\n"
+           "# TYPE axon_wifi_reconnects_total counter\n"
+           "axon_wifi_reconnects_total %u\n", metrics.wifiReconnects) ;
+
+    // Values that have never been retrieved are left out rather than reported as 0
+    append(_body,
+           "# HELP axon_value Most recently retrieved value of each key.\n"
+           "# TYPE axon_value gauge\n") ;
+    for (uint8_t i = 0; i < Config::valueSourceCount; i++) {
+        if (history != nullptr && history[i].count() == 0) continue ;
+        append(_body,
+            "axon_value{key=\"%s\"} %.15g\n", Config::valueSources[i].key.c_str(),
+            history != nullptr ? history[i].latest() : -DBL_MAX) ;
+    }
+}
+
+void MetricsServer::formatLive(uint32_t now, bool widest) {
+
+    clear(_live) ;
+
+    append(_live,
+           "# HELP axon_uptime_seconds Time since boot.\n"
+           "# TYPE axon_uptime_seconds gauge\n"
+           "axon_uptime_seconds %u\n", widest ? UINT32_MAX : now / 1000) ;
+
+    append(_live,
+           "# HELP axon_free_heap_bytes Free heap memory.\n"
+           "# TYPE axon_free_heap_bytes gauge\n"
+           "axon_free_heap_bytes %u\n", widest ? UINT32_MAX : ESP.getFreeHeap()) ;
+
+    append(_live,
+           "# HELP axon_largest_free_block_bytes Largest block of heap memory that can be allocated.\n"
+           "# TYPE axon_largest_free_block_bytes gauge\n"
+           "axon_largest_free_block_bytes %u\n", widest ? UINT32_MAX : ESP.getMaxFreeBlockSize()) ;
+
+    append(_live,
+           "# HELP axon_wifi_rssi_dbm WiFi signal strength.\n"
+           "# TYPE axon_wifi_rssi_dbm gauge\n"
+           "axon_wifi_rssi_dbm %d\n", widest ? INT32_MIN : (int32_t) WiFi.RSSI()) ;
+
+    // Values that have never been retrieved are left out rather than reported as 0
+    append(_live,
+           "# HELP axon_value_age_seconds Time since each value was last retrieved.\n"
+           "# TYPE axon_value_age_seconds gauge\n") ;
+    for (uint8_t i = 0; i < Config::valueSourceCount; i++) {
+        if (!widest && _history[i].count() == 0) continue ;
+        append(_live,
+            "axon_value_age_seconds{key=\"%s\"} %u\n", Config::valueSources[i].key.c_str(),
+            widest ? UINT32_MAX : ( now - _history[i].latestTime() ) / 1000) ;
+    }
+}
+
+void MetricsServer::respond() {
+
+    // The lines that change with time are formatted now, so they are correct at the moment of the scrape
+    formatLive(millis(), false) ;
+
+    clear(_header) ;
+    append(_header,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: %u\r\n"
+        "Connection: close\r\n\r\n", _body.length + _live.length) ;
+
+    // Writes return as soon as the data is queued rather than waiting for it to be acknowledged
+    _client.setSync(false) ;
+    _sending = true ;
+    _sent = 0 ;
+    sendPending() ;
+}
+
+void MetricsServer::sendPending() {
+
+    // The response is larger than the socket's send buffer, so it goes out a piece at a time
+    // as the client acknowledges what it has received. Only what there is room for is written,
+    // so a write never has to wait
+    const Text* parts[] = { &_header, &_body, &_live } ;
+    uint16_t offset = 0 ;
+    for (uint8_t i = 0; i < 3; i++) {
+        const Text& part = *parts[i] ;
+
+        if (_sent < offset + part.length) {
+            size_t room = _client.availableForWrite() ;
+            if (room == 0) return ;
+
+            uint16_t start = _sent - offset ;
+            size_t length = part.length - start ;
+            if (length > room) length = room ;
+
+            _sent += _client.write((const uint8_t*) part.buffer + start, length) ;
+            if (_sent < offset + part.length) return ;
+        }
+        offset += part.length ;
+    }
+
+    closeClient() ;
+}
+
+void MetricsServer::closeClient() {
+
+    // Queued data is still sent after the connection is closed. stop() with no argument would
+    // wait for it to be acknowledged, so the shortest possible wait is given instead
+    _client.stop(1) ;
+    _hasClient = false ;
+    _sending = false ;
+
+    // The body can be replaced now that it is no longer being sent
+    if (_updatePending) {
+        _updatePending = false ;
+        formatBody(_metrics, _history) ;
+    }
+}
+
+MetricsServer::MetricsServer() : _server(Config::metricsPort) {
+    _header = { _headerBuffer, sizeof(_headerBuffer), 0, 0 } ;
+    _body = { _bodyBuffer, sizeof(_bodyBuffer), 0, 0 } ;
+    _live = { _liveBuffer, sizeof(_liveBuffer), 0, 0 } ;
+    clear(_header) ;
+    clear(_body) ;
+    clear(_live) ;
+    _ready = false ;
+    memset(&_metrics, 0, sizeof(_metrics)) ;
+    _history = nullptr ;
+    _updatePending = false ;
+    _hasClient = false ;
+    _clientStart = 0 ;
+    _endMatched = 0 ;
+    _sending = false ;
+    _sent = 0 ;
+}
+
+void MetricsServer::begin() {
+
+    // Format the widest text this config can produce, with every counter and value at its longest,
+    // to make sure no real response will ever be cut short
+    PollMetrics widest ;
+    memset(&widest, 0xff, sizeof(widest)) ;
+    widest.circuitOpen = true ;
+    formatBody(widest, nullptr) ;
+    formatLive(0, true) ;
+    if (_body.needed >= _body.size || _live.needed >= _live.size) {
+        Serial.printf("Metrics buffers are too small for this config! The body needs %u of %u bytes "
+            "and the per-scrape lines %u of %u. Increase BODY_SIZE or LIVE_SIZE in MetricsServer.h\n",
+            _body.needed + 1, _body.size, _live.needed + 1, _live.size) ;
+    }
+    clear(_body) ;
+    clear(_live) ;
+
+    _server.begin() ;
+    _server.setNoDelay(true) ;
+}
+
+void MetricsServer::update(const PollMetrics& metrics, const SourceHistory* history) {
+
+    _metrics = metrics ;
+    _history = history ;
+    _ready = true ;
+
+    // Changing the body while it is being sent would corrupt the response
+    if (_sending) {
+        _updatePending = true ;
+        return ;
+    }
+    formatBody(_metrics, _history) ;
+}
+
+void MetricsServer::handle() {
+
+    // Case: no client yet. Accept one if it is waiting
+    if (!_hasClient) {
+        _client = _server.available() ;
+        if (!_client) return ;
+
+        _hasClient = true ;
+        _clientStart = millis() ;
+        _endMatched = 0 ;
+    }
+
+    // Give up on clients that are too slow to send their request or to take the response
+    if (millis() - _clientStart >= Config::metricsRequestTimeout) {
+        closeClient() ;
+        return ;
+    }
+
+    // Case: the response is being sent. Send the next piece if there is room for it
+    if (_sending) {
+        if (_client.connected()) {
+            sendPending() ;
+        }
+        else {
+            closeClient() ;
+        }
+        return ;
+    }
+
+    // Read whatever has arrived of the request, without waiting for more.
+    // Every request gets the same response, so only its end ("\r\n\r\n") matters
+    const char* end = "\r\n\r\n" ;
+    while (_endMatched < 4 && _client.available() > 0) {
+        char c = _client.read() ;
+        if (c == end[_endMatched]) {
+            _endMatched++ ;
+        }
+        else {
+            _endMatched = c == '\r' ? 1 : 0 ;
+        }
+    }
+
+    // Case: the request is complete. Respond, unless there is nothing to serve yet
+    if (_endMatched == 4) {
+        if (_ready) {
+            respond() ;
+        }
+        else {
+            closeClient() ;
+        }
+        return ;
+    }
+
+    // Case: still waiting for the rest of the request. Give up on clients that are gone
+    if (!_client.connected()) {
+        closeClient() ;
+    }
+}
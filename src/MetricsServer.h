@@ -0,0 +1,189 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#include "Config.h"
+#include "RetryScheduler.h"
+#include "ValueHistory.h"
+
+namespace ECG {
+
+// Counters kept by the device about its polls of the API
+struct PollMetrics {
+    uint32_t polls ;
+    uint32_t successes ;
+    uint32_t failures[FAILURE_CAUSE_COUNT] ;  // Indexed by FailureCause
+    uint32_t lastRequestMs ;                  // Time taken to fetch every endpoint on the most recent poll
+    uint32_t worstRequestMs ;                 // Longest time taken to fetch every endpoint on any poll
+    uint32_t lastParseUs ;                    // Time taken to parse the payloads of the most recent poll
+    uint32_t lastPayloadBytes ;               // Size of the payloads of the most recent poll
+    uint32_t cborResponses ;                  // Responses received in CBOR
+    uint32_t jsonResponses ;                  // Responses received in JSON
+    uint32_t wifiReconnects ;                 // Times the WiFi connection came back after being lost
+    bool circuitOpen ;
+    uint32_t meanTimeToRecoveryMs ;
+} ;
+
+/*
+* Serves the device's metrics on the LAN in Prometheus text format
+*
+* Most of the response is formatted once per poll by update() into a fixed buffer. Only the
+* lines that change with time (uptime, heap, WiFi signal and the age of each value) are formatted
+* per scrape, into a small fixed buffer, so a scrape allocates nothing. handle() never waits: a
+* client's request is read, and the response sent, over as many calls as it takes, so serving
+* metrics does not hold up polling or the display.
+*/
+class MetricsServer {
+
+private:
+
+    // Text formatted into one of the fixed buffers below
+    struct Text {
+        char* buffer ;
+        uint16_t size ;
+        uint16_t length ;
+        uint16_t needed ;   // Length the text would have had if the buffer were big enough
+    } ;
+
+    // Buffer sizes, from the widest text the formats in MetricsServer.cpp produce. Each value source
+    // adds a line to the body and to the per-scrape lines, which fits keys of up to 50 characters.
+    // begin() checks that the widest text the config can produce fits
+    static const uint16_t BODY_SIZE = 2176 + 96 * Config::valueSourceCount ;
+    static const uint16_t LIVE_SIZE = 640 + 96 * Config::valueSourceCount ;
+
+    WiFiServer _server ;
+
+    // Response buffers. The body formatted by update() is sent between the header and the
+    // lines formatted per scrape
+    char _headerBuffer[128] ;
+    char _bodyBuffer[BODY_SIZE] ;
+    char _liveBuffer[LIVE_SIZE] ;
+    Text _header ;
+    Text _body ;
+    Text _live ;
+
+    // Whether update() has been called yet
+    bool _ready ;
+
+    // The metrics and history passed to update(). Kept so that the body can be formatted
+    // once a response that is still using the old body has been sent
+    PollMetrics _metrics ;
+    const SourceHistory* _history ;
+    bool _updatePending ;
+
+    // The client currently being served, if any
+    WiFiClient _client ;
+    bool _hasClient ;
+
+    // millis() when the client was accepted
+    uint32_t _clientStart ;
+
+    // Number of characters of the "\r\n\r\n" that ends the request seen so far
+    uint8_t _endMatched ;
+
+    // Whether the response is being sent, and how much of it has been
+    bool _sending ;
+    uint16_t _sent ;
+
+    /*
+    * Empty a text buffer
+    */
+    static void clear(Text& text) ;
+
+    /*
+    * Append formatted text to a buffer. Text that does not fit is left out, along with
+    * everything appended after it, and the first loss is logged
+    *
+    * Parameters:
+    *   text: The buffer
+    *   format, ...: As for printf
+    */
+    static void append(Text& text, const char* format, ...) ;
+
+    /*
+    * Format the part of the response that only changes when the device polls
+    *
+    * Parameters:
+    *   metrics: The poll counters kept by the device
+    *   history: The history of each entry in Config::valueSources, or nullptr to format
+    *            every value as the widest number possible
+    */
+    void formatBody(const PollMetrics& metrics, const SourceHistory* history) ;
+
+    /*
+    * Format the lines that change with time
+    *
+    * Parameters:
+    *   now: millis() at the time of the scrape
+    *   widest: If true, every number is formatted at its widest instead of its real value
+    */
+    void formatLive(uint32_t now, bool widest) ;
+
+    /*
+    * Format the lines that change with time and the header, and start sending the response
+    */
+    void respond() ;
+
+    /*
+    * Send as much of the response as the client's send buffer has room for, without waiting.
+    * Closes the connection once all of it has been sent
+    */
+    void sendPending() ;
+
+    /*
+    * Close the connection to the current client without waiting for unsent data to be acknowledged
+    */
+    void closeClient() ;
+
+public:
+
+    MetricsServer() ;
+
+    /*
+    * Check that the buffers are big enough, and start listening on Config::metricsPort
+    */
+    void begin() ;
+
+    /*
+    * Reformat the metrics response. Called after each poll
+    * If a response is being sent, the new one is formatted once it has been
+    *
+    * Parameters:
+    *   metrics: The poll counters kept by the device
+    *   history: The history of each entry in Config::valueSources
+    */
+    void update(const PollMetrics& metrics, const SourceHistory* history) ;
+
+    /*
+    * Make progress on serving a scrape: accept a client, read what has arrived of its request,
+    * and send what fits of the response once the request is complete. Returns immediately if
+    * there is nothing to do. Clients that are not served within Config::metricsRequestTimeout are dropped
+    */
+    void handle() ;
+
+} ; // class MetricsServer
+
+} // namespace ECG
+
+#endif // METRICS_SERVER_H
@@ -0,0 +1,54 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+// TODO: Should these be global variables rather than preprocessor definitions?
+
+// Debugging options
+#define SHOW_WIFI_DIAGNISTICS 0
+#define SHOW_HTTP_HEADERS 0
+#define SHOW_PAYLOAD 0
+#define SHOW_SERVO_MOVES 0
+#define SHOW_BOOT_TIMINGS 1
+
+// Testing options
+// When enabled, every poll in the first SIMULATED_OUTAGE_SECONDS of each SIMULATED_OUTAGE_PERIOD_SECONDS
+// fails as if the API host was unreachable. Used to measure mean time to recovery.
+#define SIMULATE_OUTAGES 0
+#define SIMULATED_OUTAGE_SECONDS 60
+#define SIMULATED_OUTAGE_PERIOD_SECONDS 300
+
+// Define LED codes by color
+#define RED_LED LED_BUILTIN
+#define BLUE_LED 2
+
+// Define LED codes by purpose
+#define ACTION_LED RED_LED
+#define NETWORK_LED BLUE_LED
+
+// Define LED toggle macros
+#define LED_ON false
+#define LED_OFF true
+
+// Define pin # that controls servo
+#define SERVO_PIN 14
+
+#endif // OPTIONS_H
@@ -0,0 +1,135 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "RetryScheduler.h"
+#include "Config.h"
+
+using namespace ECG ;
+
+// Note: functions in this file should appear in the same order
+// as their declerations appear in their header.
+
+RetryScheduler::RetryScheduler() {
+    _consecutiveFailures = 0 ;
+    _lastCause = FAILURE_NONE ;
+    _circuitOpen = false ;
+    _outageStart = 0 ;
+    _recoveries = 0 ;
+    _totalRecoveryMs = 0 ;
+}
+
+bool RetryScheduler::isPermanent(FailureCause cause) {
+    return cause == FAILURE_NOT_FOUND || cause == FAILURE_PARSE ;
+}
+
+const char* RetryScheduler::causeName(FailureCause cause) {
+    switch (cause) {
+        case FAILURE_NONE:        return "none" ;
+        case FAILURE_WIFI:        return "wifi" ;
+        case FAILURE_CONNECT:     return "connect" ;
+        case FAILURE_TIMEOUT:     return "timeout" ;
+        case FAILURE_HTTP_SERVER: return "http_server" ;
+        case FAILURE_NOT_FOUND:   return "not_found" ;
+        case FAILURE_PARSE:       return "parse" ;
+        default:                  break ;
+    }
+    return "unknown" ;
+}
+
+void RetryScheduler::recordSuccess() {
+
+    // Case: this success ends an outage
+    // Measure how long it lasted and fold it into the running mean
+    if (_consecutiveFailures > 0) {
+        uint32_t outageMs = millis() - _outageStart ;
+        _recoveries++ ;
+        _totalRecoveryMs += outageMs ;
+
+        Serial.printf("Recovered after %u failed polls and %u ms. Mean time to recovery: %u ms over %u outages.\n",
+            _consecutiveFailures, outageMs, meanTimeToRecovery(), _recoveries) ;
+    }
+
+    if (_circuitOpen) {
+        Serial.printf("Circuit breaker closed.\n") ;
+    }
+
+    _consecutiveFailures = 0 ;
+    _lastCause = FAILURE_NONE ;
+    _circuitOpen = false ;
+}
+
+void RetryScheduler::recordFailure(FailureCause cause) {
+
+    // The first failure after a success marks the start of an outage
+    if (_consecutiveFailures == 0) {
+        _outageStart = millis() ;
+    }
+
+    // Saturate rather than wrap around during very long outages
+    if (_consecutiveFailures < UINT16_MAX) {
+        _consecutiveFailures++ ;
+    }
+    _lastCause = cause ;
+
+    // Open the circuit after repeated failures, or straight away if retrying will not help
+    if (!_circuitOpen &&
+        (isPermanent(cause) || _consecutiveFailures >= Config::circuitBreakerThreshold)) {
+        _circuitOpen = true ;
+        Serial.printf("Circuit breaker opened after %u failed polls (last cause: %s). "
+            "Probing every %u seconds.\n", _consecutiveFailures, causeName(cause), nextDelay() / 1000) ;
+    }
+}
+
+uint32_t RetryScheduler::nextDelay() {
+
+    // Case: all is well
+    if (_consecutiveFailures == 0) {
+        return Config::pollInterval ;
+    }
+
+    // Case: circuit is open, so only probe occasionally
+    // Permanent failures are probed less often as they are unlikely to fix themselves quickly
+    if (_circuitOpen) {
+        return isPermanent(_lastCause)
+            ? Config::permanentFailureProbeInterval
+            : Config::circuitProbeInterval ;
+    }
+
+    // Case: transient failure with the circuit closed
+    // Exponential backoff: base * 2^(failures - 1), capped at the maximum delay.
+    // The shift is capped as well so that it can not overflow
+    uint8_t shift = _consecutiveFailures - 1 < 16 ? _consecutiveFailures - 1 : 16 ;
+    uint32_t backoff = Config::retryBaseDelay << shift ;
+    if (backoff > Config::retryMaxDelay) {
+        backoff = Config::retryMaxDelay ;
+    }
+
+    // Add jitter so that many devices recovering from the same outage do not retry in lockstep.
+    // Half of the delay is fixed and the other half is random
+    return backoff / 2 + (uint32_t) random(backoff / 2 + 1) ;
+}
+
+bool RetryScheduler::isCircuitOpen() {
+    return _circuitOpen ;
+}
+
+uint32_t RetryScheduler::meanTimeToRecovery() {
+    if (_recoveries == 0) return 0 ;
+    return _totalRecoveryMs / _recoveries ;
+}
@@ -0,0 +1,120 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef RETRY_SCHEDULER_H
+#define RETRY_SCHEDULER_H
+
+#include <Arduino.h>
+
+namespace ECG {
+
+// Reasons a poll of the API can fail
+// Each cause is either transient (worth retrying soon) or permanent (needs a config fix
+// or a server-side change, so retrying quickly would only waste power and bandwidth)
+enum FailureCause {
+    FAILURE_NONE,
+    FAILURE_WIFI,        // transient: not associated with the WiFi network
+    FAILURE_CONNECT,     // transient: TCP connection to the API host failed
+    FAILURE_TIMEOUT,     // transient: the API host was too slow to respond, or stopped responding
+    FAILURE_HTTP_SERVER, // transient: server replied with an unexpected status code or an empty body
+    FAILURE_NOT_FOUND,   // permanent: API endpoint returned 404
+    FAILURE_PARSE,       // permanent: payload was retrieved but the target value could not be found
+    FAILURE_CAUSE_COUNT  // Not a cause. The number of entries above, for sizing tables
+} ;
+
+class RetryScheduler {
+
+private:
+
+    // Number of failed polls since the last successful one
+    uint16_t _consecutiveFailures ;
+
+    // Cause of the most recent failure, FAILURE_NONE after a success
+    FailureCause _lastCause ;
+
+    // When the circuit is open, polls are only made at the (slow) probe interval
+    bool _circuitOpen ;
+
+    // millis() at the first failure of the current outage. Only meaningful while _consecutiveFailures > 0
+    uint32_t _outageStart ;
+
+    // Totals used to compute the mean time to recovery
+    uint32_t _recoveries ;
+    uint32_t _totalRecoveryMs ;
+
+public:
+
+    RetryScheduler() ;
+
+    /*
+    * Check whether a failure cause is permanent
+    *
+    * Return: true if retrying quickly is unlikely to help, else false
+    */
+    static bool isPermanent(FailureCause cause) ;
+
+    /*
+    * Get a human readable name for a failure cause
+    *
+    * Return: a short string describing the cause
+    */
+    static const char* causeName(FailureCause cause) ;
+
+    /*
+    * Record a successful poll. Closes the circuit if it was open and
+    * updates the mean time to recovery if this ends an outage.
+    */
+    void recordSuccess() ;
+
+    /*
+    * Record a failed poll. Opens the circuit once Config::circuitBreakerThreshold
+    * consecutive failures have occured, or immediately for permanent failures.
+    *
+    * Parameters:
+    *   cause: The reason the poll failed
+    */
+    void recordFailure(FailureCause cause) ;
+
+    /*
+    * Get the time to wait before the next poll
+    *
+    * Return: The normal poll interval if the last poll succeeded, a jittered exponential
+    *   backoff after a transient failure, or the probe interval if the circuit is open
+    */
+    uint32_t nextDelay() ;
+
+    /*
+    * Check if the circuit breaker is open (i.e. the device is only probing for recovery)
+    *
+    * Return: true if the circuit is open, else false
+    */
+    bool isCircuitOpen() ;
+
+    /*
+    * Get the mean time to recovery over all outages since boot
+    *
+    * Return: mean outage duration in milliseconds, or 0 if there have been no recoveries
+    */
+    uint32_t meanTimeToRecovery() ;
+
+} ; // class RetryScheduler
+
+} // namespace ECG
+
+#endif // RETRY_SCHEDULER_H
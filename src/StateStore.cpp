@@ -0,0 +1,143 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "StateStore.h"
+
+#include <EEPROM.h>
+
+using namespace ECG ;
+
+// Note: functions in this file should appear in the same order
+// as their declerations appear in their header.
+
+// Records saved with a different number of values or channels are not used, as their contents
+// would not line up with the current config
+const uint32_t SAVED_STATE_MAGIC = 0xA7050000 | ( Config::valueSourceCount << 8 ) | Config::outputChannelCount ;
+
+// Offset in 4 byte blocks of the record in RTC user memory
+const uint32_t RTC_STATE_OFFSET = 0 ;
+
+// There are 512 bytes of RTC user memory. Too many values or channels will not fit
+static_assert(sizeof(SavedState) + RTC_STATE_OFFSET * 4 <= 512, "SavedState does not fit in RTC user memory") ;
+
+uint32_t StateStore::checksumOf(const SavedState& state) {
+
+    // FNV-1a hash
+    const uint8_t* bytes = (const uint8_t*) &state ;
+    uint32_t hash = 2166136261u ;
+    for (size_t i = 0; i < offsetof(SavedState, checksum); i++) {
+        hash ^= bytes[i] ;
+        hash *= 16777619u ;
+    }
+    return hash ;
+}
+
+bool StateStore::isValid(const SavedState& state) {
+    return state.magic == SAVED_STATE_MAGIC && state.checksum == checksumOf(state) ;
+}
+
+bool StateStore::sameContents(const SavedState& a, const SavedState& b) {
+
+    for (uint8_t i = 0; i < Config::valueSourceCount; i++) {
+        if (a.hasValue[i] != b.hasValue[i] || a.values[i] != b.values[i]) return false ;
+    }
+    for (uint8_t i = 0; i < Config::outputChannelCount; i++) {
+        if (a.positions[i] != b.positions[i]) return false ;
+    }
+    return true ;
+}
+
+StateStore::StateStore() {
+    // Zeroing the records makes them invalid until something is loaded or saved
+    memset(&_rtcState, 0, sizeof(_rtcState)) ;
+    memset(&_flashState, 0, sizeof(_flashState)) ;
+    _lastFlashWrite = 0 ;
+    _hasWrittenFlash = false ;
+    _bootCount = 1 ;
+}
+
+bool StateStore::load(SavedState& state) {
+
+    // The EEPROM library keeps a copy of this in RAM, so it only needs to be set up once
+    EEPROM.begin(sizeof(SavedState)) ;
+
+    // Both kinds of storage are read, as either may hold the newer record
+    SavedState rtcState ;
+    bool rtcValid = ESP.rtcUserMemoryRead(RTC_STATE_OFFSET, (uint32_t*) &rtcState, sizeof(rtcState))
+        && isValid(rtcState) ;
+
+    SavedState flashState ;
+    EEPROM.get(0, flashState) ;
+    bool flashValid = isValid(flashState) ;
+
+    if (rtcValid) _rtcState = rtcState ;
+    if (flashValid) _flashState = flashState ;
+
+    if (!rtcValid && !flashValid) return false ;
+
+    // Use whichever record was saved last
+    if (rtcValid && ( !flashValid || rtcState.sequence >= flashState.sequence )) {
+        state = rtcState ;
+    }
+    else {
+        state = flashState ;
+    }
+
+    _bootCount = state.bootCount + 1 ;
+    return true ;
+}
+
+void StateStore::save(SavedState& state) {
+
+    // The sequence number continues from the newest record, whichever kind of storage it is in
+    uint32_t sequence = _rtcState.sequence > _flashState.sequence ? _rtcState.sequence : _flashState.sequence ;
+
+    // Case: RTC memory is out of date
+    // It does not wear out, so it is always kept up to date
+    if (!isValid(_rtcState) || !sameContents(state, _rtcState)) {
+        state.magic = SAVED_STATE_MAGIC ;
+        state.sequence = ++sequence ;
+        state.bootCount = _bootCount ;
+        state.checksum = checksumOf(state) ;
+
+        ESP.rtcUserMemoryWrite(RTC_STATE_OFFSET, (uint32_t*) &state, sizeof(state)) ;
+        _rtcState = state ;
+    }
+
+    // Case: flash is out of date
+    // Only written if enough time has passed, so a quickly changing value can not wear it out.
+    // Anything that changes in the meantime is written on a later call
+    bool flashDue = !_hasWrittenFlash || millis() - _lastFlashWrite >= Config::flashSaveInterval ;
+    if (flashDue && ( !isValid(_flashState) || !sameContents(_rtcState, _flashState) )) {
+        EEPROM.put(0, _rtcState) ;
+        if (EEPROM.commit()) {
+            _flashState = _rtcState ;
+            _lastFlashWrite = millis() ;
+            _hasWrittenFlash = true ;
+            Serial.printf("Saved display state to flash (save #%u).\n", _flashState.sequence) ;
+        }
+        else {
+            Serial.printf("Saving display state to flash failed!\n") ;
+        }
+    }
+}
+
+uint32_t StateStore::bootCount() {
+    return _bootCount ;
+}
@@ -0,0 +1,117 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef STATE_STORE_H
+#define STATE_STORE_H
+
+#include <Arduino.h>
+
+#include "Config.h"
+
+namespace ECG {
+
+// What the device remembers across reboots so that it can show something meaningful straight away
+struct SavedState {
+    uint32_t magic ;                                 // Identifies a valid record for the current config
+    uint32_t sequence ;                              // Number of saves ever made, the newest record wins
+    uint32_t bootCount ;                             // Number of the boot during which the record was saved
+    uint32_t retrievedAtSeconds ;                    // Uptime on that boot when the values were retrieved
+    double values[Config::valueSourceCount] ;        // Most recent value of each entry in Config::valueSources
+    uint8_t hasValue[Config::valueSourceCount] ;     // Whether each value had been retrieved
+    uint16_t positions[Config::outputChannelCount] ; // Final position of each entry in Config::outputChannels
+    uint32_t checksum ;                              // Detects records that were only partly written
+} ;
+
+/*
+* Keeps a copy of the device's last good values and display positions in RTC memory
+* and in flash, and reads them back after a reboot
+*
+* RTC memory survives resets but not loss of power, and does not wear out, so it is written
+* whenever the state changes. Flash survives loss of power but wears out with each write,
+* so it is only written when the state has changed and Config::flashSaveInterval has passed
+* since the last write.
+*/
+class StateStore {
+
+private:
+
+    // The state most recently written to each kind of storage
+    SavedState _rtcState ;
+    SavedState _flashState ;
+
+    // millis() of the last write to flash, and whether there has been one this boot
+    uint32_t _lastFlashWrite ;
+    bool _hasWrittenFlash ;
+
+    // Number of this boot, one more than that of the newest record found
+    uint32_t _bootCount ;
+
+    /*
+    * Calculate the checksum of a record, covering everything but the checksum itself
+    *
+    * Return: the checksum
+    */
+    static uint32_t checksumOf(const SavedState& state) ;
+
+    /*
+    * Check that a record is complete and was made with the current config
+    *
+    * Return: true if the record can be used, else false
+    */
+    static bool isValid(const SavedState& state) ;
+
+    /*
+    * Compare the parts of two records that describe the display
+    *
+    * Return: true if the values and positions are the same, else false
+    */
+    static bool sameContents(const SavedState& a, const SavedState& b) ;
+
+public:
+
+    StateStore() ;
+
+    /*
+    * Read the newest valid record from RTC memory or flash
+    *
+    * Parameters:
+    *   state: Set to the record found
+    *
+    * Return: true if a valid record was found, else false
+    */
+    bool load(SavedState& state) ;
+
+    /*
+    * Save the current state. Only what has changed is written, and flash writes are rate limited
+    *
+    * Parameters:
+    *   state: The state to save. Its bookkeeping fields (magic, sequence, etc.) are filled in here
+    */
+    void save(SavedState& state) ;
+
+    /*
+    * Return: the number of this boot, counting from 1
+    */
+    uint32_t bootCount() ;
+
+} ; // class StateStore
+
+} // namespace ECG
+
+#endif // STATE_STORE_H
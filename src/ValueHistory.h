@@ -0,0 +1,223 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef VALUE_HISTORY_H
+#define VALUE_HISTORY_H
+
+#include <Arduino.h>
+
+#include "Config.h"
+
+namespace ECG {
+
+/*
+* A fixed-size ring buffer of timestamped samples of one value
+*
+* Statistics are updated as each sample is added, so reading them never
+* requires scanning the history. The memory used is fixed at compile time by CAPACITY.
+*
+* Template parameters:
+*   CAPACITY: The number of most recent samples kept (the window used for min, max and rate)
+*/
+template <uint16_t CAPACITY>
+class ValueHistory {
+
+private:
+
+    struct Sample {
+        uint32_t time ;  // millis() when the sample was taken
+        double value ;
+    } ;
+
+    // Samples are stored by sequence number: sample n lives at _samples[n % CAPACITY]
+    Sample _samples[CAPACITY] ;
+
+    // Total number of samples ever added. The window holds the last min(_added, CAPACITY) of them
+    uint32_t _added ;
+
+    // Exponentially weighted moving average of every sample added
+    double _ewma ;
+
+    // Monotonic queues of sequence numbers, used to track the min and max of the window.
+    // Values of the samples they refer to are increasing (min) or decreasing (max) from front to back,
+    // so the front is always the answer. Each is a ring of CAPACITY entries; front and count index into it
+    uint32_t _minQueue[CAPACITY] ;
+    uint16_t _minFront ;
+    uint16_t _minCount ;
+
+    uint32_t _maxQueue[CAPACITY] ;
+    uint16_t _maxFront ;
+    uint16_t _maxCount ;
+
+    const Sample& sampleAt(uint32_t sequence) const {
+        return _samples[sequence % CAPACITY] ;
+    }
+
+    /*
+    * Add a new sequence number to the back of a monotonic queue, and drop entries that
+    * can no longer be the min (or max) or that have left the window
+    *
+    * Parameters:
+    *   queue, front, count: The queue to update
+    *   sequence: Sequence number of the sample just added
+    *   keepSmaller: true for the min queue, false for the max queue
+    */
+    void pushMonotonic(uint32_t* queue, uint16_t& front, uint16_t& count, uint32_t sequence, bool keepSmaller) {
+
+        // The front entry leaves the queue once its sample has been overwritten in the ring buffer.
+        // This is checked first, as the overwritten slot now holds the new value
+        if (count > 0 && sequence - queue[front] >= CAPACITY) {
+            front = (front + 1) % CAPACITY ;
+            count-- ;
+        }
+
+        double value = sampleAt(sequence).value ;
+
+        // Entries at the back that are no better than the new value will never be the answer again
+        while (count > 0) {
+            double back = sampleAt(queue[(front + count - 1) % CAPACITY]).value ;
+            if (keepSmaller ? back < value : back > value) break ;
+            count-- ;
+        }
+
+        queue[(front + count) % CAPACITY] = sequence ;
+        count++ ;
+    }
+
+public:
+
+    ValueHistory() {
+        clear() ;
+    }
+
+    /*
+    * Remove all samples
+    */
+    void clear() {
+        _added = 0 ;
+        _ewma = 0 ;
+        _minFront = 0 ;
+        _minCount = 0 ;
+        _maxFront = 0 ;
+        _maxCount = 0 ;
+    }
+
+    /*
+    * Add a sample, overwriting the oldest one if the buffer is full
+    *
+    * Parameters:
+    *   time: millis() when the value was retrieved
+    *   value: The retrieved value
+    *   ewmaWeight: Weight given to this sample in the moving average, between 0 and 1
+    */
+    void add(uint32_t time, double value, double ewmaWeight) {
+
+        uint32_t sequence = _added ;
+        _samples[sequence % CAPACITY].time = time ;
+        _samples[sequence % CAPACITY].value = value ;
+
+        // The first sample starts the average off rather than being blended with 0
+        _ewma = _added == 0 ? value : _ewma + ewmaWeight * ( value - _ewma ) ;
+        _added++ ;
+
+        pushMonotonic(_minQueue, _minFront, _minCount, sequence, true) ;
+        pushMonotonic(_maxQueue, _maxFront, _maxCount, sequence, false) ;
+    }
+
+    /*
+    * Return: the number of samples currently in the window
+    */
+    uint16_t count() const {
+        return _added < CAPACITY ? _added : CAPACITY ;
+    }
+
+    /*
+    * Return: the most recent value, or 0 if there are no samples
+    */
+    double latest() const {
+        return _added == 0 ? 0 : sampleAt(_added - 1).value ;
+    }
+
+    /*
+    * Return: millis() when the most recent value was added, or 0 if there are no samples
+    */
+    uint32_t latestTime() const {
+        return _added == 0 ? 0 : sampleAt(_added - 1).time ;
+    }
+
+    /*
+    * Return: the exponentially weighted moving average of all samples added
+    */
+    double ewma() const {
+        return _ewma ;
+    }
+
+    /*
+    * Return: the smallest value in the window, or 0 if there are no samples
+    */
+    double min() const {
+        return _minCount == 0 ? 0 : sampleAt(_minQueue[_minFront]).value ;
+    }
+
+    /*
+    * Return: the largest value in the window, or 0 if there are no samples
+    */
+    double max() const {
+        return _maxCount == 0 ? 0 : sampleAt(_maxQueue[_maxFront]).value ;
+    }
+
+    /*
+    * Average rate of change across the window
+    *
+    * Return: change in value per minute between the oldest and newest samples,
+    *   or 0 if there are fewer than two samples
+    */
+    double deltaPerMinute() const {
+        if (count() < 2) return 0 ;
+
+        const Sample& newest = sampleAt(_added - 1) ;
+        const Sample& oldest = sampleAt(_added - count()) ;
+
+        uint32_t elapsed = newest.time - oldest.time ;
+        if (elapsed == 0) return 0 ;
+
+        return ( newest.value - oldest.value ) * 60000.0 / elapsed ;
+    }
+
+    /*
+    * Check whether the most recent value is too old to be trusted
+    *
+    * Parameters:
+    *   now: The current millis()
+    *   maxAge: Age in milliseconds after which a value is stale
+    *
+    * Return: true if there are no samples or the newest one is older than maxAge, else false
+    */
+    bool isStale(uint32_t now, uint32_t maxAge) const {
+        return _added == 0 || now - latestTime() > maxAge ;
+    }
+
+} ; // class ValueHistory
+
+// The recent samples of one of the values in Config::valueSources
+typedef ValueHistory<Config::historySize> SourceHistory ;
+
+} // namespace ECG
+
+#endif // VALUE_HISTORY_H
@@ -28,12 +28,12 @@ void loop() {
   static ECG::Axon device ;
 
   // Loop through a basic operational loop until the device ends up in an invalid state
+  // Failed polls leave the last good value on display and are retried with backoff
   while (device.isValid()) {
-    device.connectToWiFi() ;
-    device.callAPI() ;
-    device.parseJson() ;
-    device.updateDisplay() ;
-    device.sleep(5000) ;
+    if (device.poll()) {
+      device.updateDisplay() ;
+    }
+    device.sleep(device.nextPollDelay()) ;
   }
 
   // If the device is in an invalid state, make an obvious flashing pattern to alert the user
@@ -0,0 +1,225 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Desktop implementations of the Arduino and ESP8266 functions declared in this directory
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+#include <chrono>
+#include <thread>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+HardwareSerial Serial ;
+EspClass ESP ;
+ESP8266WiFiClass WiFi ;
+
+// The largest amount of unsent data a client may have queued, as on the device with its
+// default network stack settings (two segments of 536 bytes)
+const size_t SEND_BUFFER_SIZE = 1072 ;
+
+static const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now() ;
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    va_list args ;
+    va_start(args, format) ;
+    int written = vprintf(format, args) ;
+    va_end(args) ;
+    fflush(stdout) ;
+    return written < 0 ? 0 : written ;
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return 40000 ;
+}
+
+uint32_t EspClass::getMaxFreeBlockSize() {
+    return 30000 ;
+}
+
+unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - bootTime).count() ;
+}
+
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - bootTime).count() ;
+}
+
+void delay(unsigned long milliseconds) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds)) ;
+}
+
+void yield() {
+}
+
+long random(long limit) {
+    return limit <= 0 ? 0 : rand() % limit ;
+}
+
+long random(long low, long high) {
+    return low + random(high - low) ;
+}
+
+WiFiClient::Socket::~Socket() {
+    close(fd) ;
+}
+
+int WiFiClient::connect(IPAddress address, uint16_t port) {
+
+    stop() ;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0) ;
+    if (fd < 0) return 0 ;
+    std::shared_ptr<Socket> socket = std::make_shared<Socket>(fd) ;
+
+    // Connect without blocking, and give up after the stream timeout as the device does
+    fcntl(fd, F_SETFL, O_NONBLOCK) ;
+    sockaddr_in server = {} ;
+    server.sin_family = AF_INET ;
+    server.sin_port = htons(port) ;
+    server.sin_addr.s_addr = address.address ;
+    if (::connect(fd, (sockaddr*) &server, sizeof(server)) < 0) {
+        if (errno != EINPROGRESS) return 0 ;
+
+        pollfd waiting = { fd, POLLOUT, 0 } ;
+        if (poll(&waiting, 1, (int) _timeout) != 1) return 0 ;
+
+        int error = 0 ;
+        socklen_t length = sizeof(error) ;
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) ;
+        if (error != 0) return 0 ;
+    }
+
+    _socket = socket ;
+    setNoDelay(_noDelay) ;
+    return 1 ;
+}
+
+size_t WiFiClient::write(const uint8_t* data, size_t length) {
+    if (!_socket) return 0 ;
+
+    // Like the device, wait up to the stream timeout for the data to be queued
+    size_t written = 0 ;
+    unsigned long start = millis() ;
+    while (written < length && millis() - start < _timeout) {
+        ssize_t sent = send(_socket->fd, data + written, length - written, MSG_NOSIGNAL) ;
+        if (sent > 0) {
+            written += sent ;
+        }
+        else
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            break ;
+        }
+        else {
+            delay(1) ;
+        }
+    }
+    return written ;
+}
+
+int WiFiClient::available() {
+    if (!_socket) return 0 ;
+    int count = 0 ;
+    if (ioctl(_socket->fd, FIONREAD, &count) < 0) return 0 ;
+    return count ;
+}
+
+int WiFiClient::read() {
+    if (!_socket) return -1 ;
+    uint8_t c ;
+    return recv(_socket->fd, &c, 1, MSG_DONTWAIT) == 1 ? c : -1 ;
+}
+
+uint8_t WiFiClient::connected() {
+    if (!_socket) return 0 ;
+
+    // The connection is open if there is data waiting, or if reading would only have to wait for some
+    char c ;
+    ssize_t peeked = recv(_socket->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) ;
+    return peeked > 0 || ( peeked < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) ) ;
+}
+
+size_t WiFiClient::availableForWrite() {
+    if (!_socket) return 0 ;
+    int queued = 0 ;
+    if (ioctl(_socket->fd, TIOCOUTQ, &queued) < 0) return 0 ;
+    return (size_t) queued >= SEND_BUFFER_SIZE ? 0 : SEND_BUFFER_SIZE - queued ;
+}
+
+void WiFiClient::setNoDelay(bool noDelay) {
+    _noDelay = noDelay ;
+    if (!_socket) return ;
+    int value = noDelay ;
+    setsockopt(_socket->fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value)) ;
+}
+
+void WiFiClient::stop() {
+    _socket.reset() ;
+}
+
+void WiFiServer::begin() {
+    _fd = socket(AF_INET, SOCK_STREAM, 0) ;
+    int reuse = 1 ;
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) ;
+
+    sockaddr_in address = {} ;
+    address.sin_family = AF_INET ;
+    address.sin_port = htons(_port) ;
+    address.sin_addr.s_addr = htonl(INADDR_ANY) ;
+    if (bind(_fd, (sockaddr*) &address, sizeof(address)) < 0 || listen(_fd, 4) < 0) {
+        Serial.printf("Could not listen on port %u: %s\n", _port, strerror(errno)) ;
+    }
+    fcntl(_fd, F_SETFL, O_NONBLOCK) ;
+}
+
+WiFiClient WiFiServer::available() {
+    WiFiClient client ;
+    if (_fd < 0) return client ;
+
+    int fd = accept(_fd, nullptr, nullptr) ;
+    if (fd >= 0) {
+        fcntl(fd, F_SETFL, O_NONBLOCK) ;
+        client._socket = std::make_shared<WiFiClient::Socket>(fd) ;
+    }
+    return client ;
+}
+
+int ESP8266WiFiClass::hostByName(const char* host, IPAddress& address, uint32_t) {
+    addrinfo hints = {} ;
+    hints.ai_family = AF_INET ;
+    hints.ai_socktype = SOCK_STREAM ;
+    addrinfo* found ;
+    if (getaddrinfo(host, nullptr, &hints, &found) != 0) return 0 ;
+
+    address.address = ( (sockaddr_in*) found->ai_addr )->sin_addr.s_addr ;
+    freeaddrinfo(found) ;
+    return 1 ;
+}
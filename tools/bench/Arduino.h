@@ -0,0 +1,93 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// The parts of the Arduino core that the networking and decoding classes use, so they can be
+// built and run on a desktop machine. Not used by the sketch itself
+
+#ifndef BENCH_ARDUINO_H
+#define BENCH_ARDUINO_H
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+class String : public std::string {
+public:
+    using std::string::string ;
+    String() {}
+    String(const std::string& other) : std::string(other) {}
+    explicit String(char c) : std::string(1, c) {}
+
+    int indexOf(char c, unsigned from = 0) const {
+        size_t i = find(c, from) ;
+        return i == npos ? -1 : (int) i ;
+    }
+    int indexOf(const char* text, unsigned from = 0) const {
+        size_t i = find(text, from) ;
+        return i == npos ? -1 : (int) i ;
+    }
+    int indexOf(const String& text, unsigned from = 0) const { return indexOf(text.c_str(), from) ; }
+    char charAt(unsigned i) const { return i < length() ? (*this)[i] : 0 ; }
+    String substring(unsigned from) const { return from < length() ? String(substr(from)) : String() ; }
+    String substring(unsigned from, unsigned to) const {
+        return from < length() && from < to ? String(substr(from, to - from)) : String() ;
+    }
+    bool startsWith(const String& prefix) const { return compare(0, prefix.length(), prefix) == 0 ; }
+    long toInt() const { return atol(c_str()) ; }
+    double toDouble() const { return atof(c_str()) ; }
+    void toLowerCase() { for (char& c : *this) c = (char) tolower((unsigned char) c) ; }
+    void trim() {
+        size_t start = find_first_not_of(" \t\r\n") ;
+        size_t end = find_last_not_of(" \t\r\n") ;
+        *this = start == npos ? String() : String(substr(start, end - start + 1)) ;
+    }
+} ;
+
+inline String operator+(const String& a, const String& b) { return String(static_cast<const std::string&>(a) + static_cast<const std::string&>(b)) ; }
+inline String operator+(const String& a, const char* b) { return String(static_cast<const std::string&>(a) + b) ; }
+inline String operator+(const char* a, const String& b) { return String(a + static_cast<const std::string&>(b)) ; }
+
+// Writes to standard output
+class HardwareSerial {
+public:
+    void begin(unsigned long) {}
+    size_t printf(const char* format, ...) __attribute__ ((format (printf, 2, 3))) ;
+} ;
+extern HardwareSerial Serial ;
+
+// The heap figures are those of the desktop process, so they are only placeholders
+class EspClass {
+public:
+    uint32_t getFreeHeap() ;
+    uint32_t getMaxFreeBlockSize() ;
+} ;
+extern EspClass ESP ;
+
+unsigned long millis() ;
+unsigned long micros() ;
+void delay(unsigned long milliseconds) ;
+void yield() ;
+long random(long limit) ;
+long random(long low, long high) ;
+
+#endif // BENCH_ARDUINO_H
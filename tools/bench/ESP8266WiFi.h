@@ -0,0 +1,38 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// The parts of the ESP8266 WiFi library that the networking classes use, on a desktop machine
+
+#ifndef BENCH_ESP8266_WIFI_H
+#define BENCH_ESP8266_WIFI_H
+
+#include "Arduino.h"
+#include "WiFiClient.h"
+
+class ESP8266WiFiClass {
+public:
+    // Looks the host up with the system resolver, which does not take a timeout
+    int hostByName(const char* host, IPAddress& address, uint32_t timeout) ;
+
+    // A desktop has no signal strength, so this is a placeholder
+    int32_t RSSI() { return -60 ; }
+} ;
+extern ESP8266WiFiClass WiFi ;
+
+#endif // BENCH_ESP8266_WIFI_H
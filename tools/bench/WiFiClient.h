@@ -0,0 +1,90 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// WiFiClient and WiFiServer on top of POSIX sockets, with the same non-blocking behaviour
+// the sketch relies on: available(), read() and availableForWrite() never wait
+
+#ifndef BENCH_WIFI_CLIENT_H
+#define BENCH_WIFI_CLIENT_H
+
+#include <memory>
+
+#include "Arduino.h"
+
+class IPAddress {
+public:
+    uint32_t address ;   // In network byte order
+    IPAddress() : address(0) {}
+} ;
+
+class WiFiClient {
+
+private:
+
+    // Copies of a client share its socket, as on the device. It is closed with the last copy
+    struct Socket {
+        int fd ;
+        Socket(int fd) : fd(fd) {}
+        ~Socket() ;
+    } ;
+    std::shared_ptr<Socket> _socket ;
+    unsigned long _timeout ;
+
+    // Nagle's algorithm is on unless turned off, as on the device
+    bool _noDelay ;
+
+    friend class WiFiServer ;
+
+public:
+
+    WiFiClient() : _timeout(1000), _noDelay(false) {}
+
+    int connect(IPAddress address, uint16_t port) ;
+    size_t write(const uint8_t* data, size_t length) ;
+    size_t print(const String& text) { return write((const uint8_t*) text.c_str(), text.length()) ; }
+    int available() ;
+    int read() ;
+    uint8_t connected() ;
+    size_t availableForWrite() ;
+    void stop() ;
+    bool stop(unsigned int) { stop() ; return true ; }
+    void setTimeout(unsigned long timeout) { _timeout = timeout ; }
+    void setSync(bool) {}
+    void setNoDelay(bool noDelay) ;
+    operator bool() { return _socket != nullptr ; }
+} ;
+
+class WiFiServer {
+
+private:
+
+    uint16_t _port ;
+    int _fd ;
+
+public:
+
+    WiFiServer(uint16_t port) : _port(port), _fd(-1) {}
+    void begin() ;
+    void setNoDelay(bool) {}
+
+    // Returns a client that is waiting to be accepted, or an empty one
+    WiFiClient available() ;
+} ;
+
+#endif // BENCH_WIFI_CLIENT_H
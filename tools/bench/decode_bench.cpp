@@ -0,0 +1,135 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*
+* Compares the size and decode time of the same document encoded as JSON and as CBOR,
+* decoding each the way Axon does: ArduinoJson for JSON and CborDecoder for CBOR
+*
+* Build and run from the root of the repository (the ArduinoJson submodule must be checked out):
+*
+*   python3 tools/stand_in_server.py --write-samples /tmp/axon-samples
+*   g++ -O2 -std=c++11 -I tools/bench tools/bench/decode_bench.cpp src/CborDecoder.cpp -o /tmp/decode_bench
+*   /tmp/decode_bench /tmp/axon-samples/project.json /tmp/axon-samples/project.cbor dataSetCount
+*
+* Times are from the desktop machine, so only the ratio between the two is meaningful for the
+* device. On the device itself, compare axon_last_parse_microseconds in the metrics with
+* Config::requestBinaryFormat on and off.
+*/
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Arduino.h"
+#include "../../src/CborDecoder.h"
+#include "../../src/libs/ArduinoJson/src/ArduinoJson.h"
+
+using namespace ECG ;
+
+// Number of times each document is decoded. The time reported is the average
+const unsigned long defaultIterations = 20000 ;
+
+// Stops the compiler from optimizing away decodes whose result is otherwise unused
+static volatile double sink ;
+
+static bool readFile(const char* path, String& contents) {
+    std::ifstream file(path, std::ios::binary) ;
+    if (!file) return false ;
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()) ;
+    return true ;
+}
+
+// Decode as Axon::parseJson does, including the buffer being created for each response
+static bool decodeJson(const String& body, const String& key, double& value) {
+    DynamicJsonBuffer jsonBuffer ;
+    JsonObject& dataRoot = jsonBuffer.parseObject(body.c_str()) ;
+    if (!dataRoot.success() || !dataRoot.containsKey(key.c_str())) return false ;
+    value = dataRoot[key.c_str()].as<double>() ;
+    return true ;
+}
+
+// Decode as Axon::parseCbor does
+static bool decodeCbor(const String& body, const String& key, double& value) {
+    CborDecoder decoder((const uint8_t*) body.c_str(), body.length()) ;
+    const String* keys[] = { &key } ;
+    bool found ;
+    return decoder.findNumbers(keys, 1, &value, &found) == 1 ;
+}
+
+// Return the average time in microseconds of one decode
+static double timeDecode(bool (*decode)(const String&, const String&, double&),
+        const String& body, const String& key, unsigned long iterations) {
+
+    auto start = std::chrono::steady_clock::now() ;
+    for (unsigned long i = 0; i < iterations; i++) {
+        double value = 0 ;
+        decode(body, key, value) ;
+        sink = value ;
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start ;
+
+    return elapsed.count() / iterations ;
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <document.json> <document.cbor> <key> [iterations]\n", argv[0]) ;
+        return 2 ;
+    }
+
+    String json, cbor ;
+    if (!readFile(argv[1], json) || !readFile(argv[2], cbor)) {
+        fprintf(stderr, "Could not read the documents\n") ;
+        return 1 ;
+    }
+    String key = argv[3] ;
+    unsigned long iterations = argc > 4 ? strtoul(argv[4], NULL, 10) : defaultIterations ;
+    if (iterations == 0) iterations = 1 ;
+
+    // Both decoders must agree before their times mean anything
+    double jsonValue, cborValue ;
+    if (!decodeJson(json, key, jsonValue)) {
+        fprintf(stderr, "Key %s was not found in the JSON\n", key.c_str()) ;
+        return 1 ;
+    }
+    if (!decodeCbor(cbor, key, cborValue)) {
+        fprintf(stderr, "Key %s was not found in the CBOR\n", key.c_str()) ;
+        return 1 ;
+    }
+    if (jsonValue != cborValue) {
+        fprintf(stderr, "The documents differ: %s is %f in JSON but %f in CBOR\n",
+            key.c_str(), jsonValue, cborValue) ;
+        return 1 ;
+    }
+
+    double jsonTime = timeDecode(decodeJson, json, key, iterations) ;
+    double cborTime = timeDecode(decodeCbor, cbor, key, iterations) ;
+
+    printf("%s = %f, average of %lu decodes\n\n", key.c_str(), jsonValue, iterations) ;
+    printf("format    bytes    microseconds\n") ;
+    printf("JSON   %8zu   %13.3f\n", json.length(), jsonTime) ;
+    printf("CBOR   %8zu   %13.3f\n", cbor.length(), cborTime) ;
+    printf("\nCBOR is %.1f%% of the size and %.1f%% of the decode time of JSON\n",
+        100.0 * cbor.length() / json.length(), 100.0 * cborTime / jsonTime) ;
+
+    return 0 ;
+}
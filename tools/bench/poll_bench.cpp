@@ -0,0 +1,99 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*
+* Times the device's poll cycle on a desktop machine: the time ApiClient takes to fetch every
+* endpoint, pipelined and one at a time, for 1, 4 and 16 endpoints. Each case also shows the
+* longest a poll is allowed to take (Config::requestTimeout per endpoint)
+*
+* Run it against the stand-in server, through tools/fault_proxy.py to give it a realistic
+* round trip time, or to check that polls stay within their limit when the network misbehaves
+* (--mode mix). Build and run from the root of the repository:
+*
+*   g++ -O2 -std=c++11 -I tools/bench tools/bench/poll_bench.cpp tools/bench/Arduino.cpp \
+*       src/ApiClient.cpp src/HttpReader.cpp -o /tmp/poll_bench
+*   python3 tools/stand_in_server.py --port 8080 &
+*   python3 tools/fault_proxy.py --upstream localhost:8080 --port 8081 --latency 50 &
+*   /tmp/poll_bench localhost 8081 20
+*
+* Arguments: host, port, the number of polls to time for each case, and optionally
+* a single number of endpoints to time instead of 1, 4 and 16
+*/
+
+#include <algorithm>
+#include <vector>
+
+#include "Arduino.h"
+#include "../../src/ApiClient.h"
+#include "../../src/Config.h"
+
+using namespace ECG ;
+
+int main(int argc, char** argv) {
+
+    if (argc < 3) {
+        Serial.printf("Usage: %s <host> <port> [polls] [endpoints]\n", argv[0]) ;
+        return 1 ;
+    }
+    String host = argv[1] ;
+    uint16_t port = atoi(argv[2]) ;
+    int polls = argc > 3 ? atoi(argv[3]) : 20 ;
+
+    // The stand-in answers every project id, so the endpoints are just numbered
+    String endpoints[16] ;
+    for (int i = 0; i < 16; i++) {
+        endpoints[i] = "/projects/" + String(std::to_string(2156 + i)) ;
+    }
+
+    // The client logs every poll, so the results are collected and printed at the end
+    std::vector<uint8_t> counts = { 1, 4, 16 } ;
+    if (argc > 4) {
+        counts = { (uint8_t) std::min(atoi(argv[4]), 16) } ;
+    }
+    String results ;
+
+    for (uint8_t count : counts) {
+        for (bool pipelining : { true, false }) {
+            std::vector<uint32_t> times ;
+            int failed = 0 ;
+
+            for (int poll = 0; poll < polls; poll++) {
+                ApiClient api(host, port, "/api/v1", endpoints, count, pipelining) ;
+
+                uint32_t start = millis() ;
+                bool succeeded = api.fetch([](uint8_t, const HttpResponse& response) {
+                    return response.status == 200 && response.body.length() > 0 ;
+                }) ;
+                times.push_back(millis() - start) ;
+                if (!succeeded) failed++ ;
+            }
+
+            std::sort(times.begin(), times.end()) ;
+            char line[96] ;
+            snprintf(line, sizeof(line), "%-10u %-11s %8u %8u %8u %8u %6d\n", count,
+                pipelining ? "pipelined" : "sequential", times.front(), times[times.size() / 2], times.back(),
+                Config::requestTimeout * count, failed) ;
+            results += line ;
+        }
+    }
+
+    Serial.printf("\n%-10s %-11s %8s %8s %8s %8s %6s\n%s", "endpoints", "mode", "min ms", "median", "max ms",
+        "limit", "failed", results.c_str()) ;
+    return 0 ;
+}
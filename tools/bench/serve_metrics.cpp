@@ -0,0 +1,75 @@
+/*
+    Arms for iSENSE
+    Copyright (C) 2018 Engaging Computing Group
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*
+* Runs the device's metrics server on a desktop machine, so it can be scraped with curl
+*
+* A made-up poll is recorded every Config::pollInterval so that the counters and values move.
+* Build and run from the root of the repository:
+*
+*   g++ -O2 -std=c++11 -I tools/bench tools/bench/serve_metrics.cpp tools/bench/Arduino.cpp \
+*       src/MetricsServer.cpp src/RetryScheduler.cpp -o /tmp/serve_metrics
+*   /tmp/serve_metrics &
+*   curl http://localhost:9100/metrics
+*/
+
+#include "Arduino.h"
+#include "../../src/MetricsServer.h"
+
+using namespace ECG ;
+
+int main() {
+
+    MetricsServer metrics ;
+    PollMetrics stats = {} ;
+    SourceHistory history[Config::valueSourceCount] ;
+
+    metrics.begin() ;
+    Serial.printf("Serving metrics on port %u\n", Config::metricsPort) ;
+
+    uint32_t lastPoll = 0 ;
+    bool polled = false ;
+    for (;;) {
+        uint32_t now = millis() ;
+
+        // Every fourth poll fails, to give the failure counters something to count
+        if (!polled || now - lastPoll >= Config::pollInterval) {
+            stats.polls++ ;
+            if (stats.polls % 4 == 0) {
+                stats.failures[FAILURE_TIMEOUT]++ ;
+            }
+            else {
+                stats.successes++ ;
+                stats.jsonResponses++ ;
+                for (uint8_t i = 0; i < Config::valueSourceCount; i++) {
+                    history[i].add(now, 1600 + stats.polls, Config::ewmaWeight) ;
+                }
+            }
+            stats.lastRequestMs = 100 + random(50) ;
+            if (stats.lastRequestMs > stats.worstRequestMs) stats.worstRequestMs = stats.lastRequestMs ;
+
+            metrics.update(stats, history) ;
+            lastPoll = now ;
+            polled = true ;
+        }
+
+        metrics.handle() ;
+        delay(1) ;
+    }
+}
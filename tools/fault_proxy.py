@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+# Arms for iSENSE
+# Copyright (C) 2018 Engaging Computing Group
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""
+A TCP proxy that puts a slow or misbehaving network between the device and a server, such as
+the stand-in, to check that every poll still finishes within the limits in Config.h.
+
+Everything sent either way is held back by --latency milliseconds before it is passed on,
+so a round trip through the proxy takes twice that long. Data is passed on in the order it
+arrived and is never held back longer than that, so pipelined requests still overlap.
+
+On top of that, --mode picks what happens to the server's responses on each connection:
+    latency  nothing more than the delay
+    trickle  bytes are passed on one at a time, --trickle milliseconds apart
+    stall    nothing is passed on after the first --after bytes, but the connection stays open
+    reset    the connection to the device is reset after the first --after bytes
+    mix      one of the above, picked at random for each connection, with --after and --trickle
+             as the upper limits of a random byte count and interval, so faults land in every phase
+
+Usage:
+    python3 fault_proxy.py --upstream localhost:8080 [--port 8081] [--latency 50]
+                           [--mode latency] [--after 100] [--trickle 20] [--seed 1]
+"""
+
+import argparse
+import asyncio
+import random
+import socket
+import struct
+import time
+
+
+MODES = ("latency", "trickle", "stall", "reset")
+
+
+# Pass everything read from reader on to writer, latency seconds after it was read,
+# misbehaving as the mode says. Raises ConnectionError if either side goes away abruptly
+async def forward(reader, writer, latency, mode="latency", after=0, trickle=0):
+    queue = asyncio.Queue()
+    passed = 0
+
+    async def receive():
+        while True:
+            data = await reader.read(4096)
+            queue.put_nowait((time.monotonic() + latency, data))
+            if not data:
+                return
+
+    async def send():
+        nonlocal passed
+        while True:
+            due, data = await queue.get()
+            wait = due - time.monotonic()
+            if wait > 0:
+                await asyncio.sleep(wait)
+
+            # The end of the stream. A stalled connection is left open for the device to give up on
+            if not data:
+                if mode != "stall" and writer.can_write_eof():
+                    writer.write_eof()
+                return
+
+            if mode in ("stall", "reset"):
+                data = data[:max(0, after - passed)]
+            if mode == "trickle":
+                for i in range(len(data)):
+                    writer.write(data[i:i + 1])
+                    await writer.drain()
+                    await asyncio.sleep(trickle)
+            elif data:
+                writer.write(data)
+                await writer.drain()
+            passed += len(data)
+
+            # Reset rather than close, by closing with a zero linger time
+            if mode == "reset" and passed >= after:
+                writer.get_extra_info("socket").setsockopt(
+                    socket.SOL_SOCKET, socket.SO_LINGER, struct.pack("ii", 1, 0))
+                writer.transport.abort()
+                raise ConnectionResetError("reset by the proxy")
+
+    tasks = [asyncio.ensure_future(receive()), asyncio.ensure_future(send())]
+    try:
+        await asyncio.gather(*tasks)
+    finally:
+        for task in tasks:
+            task.cancel()
+
+
+async def handle(client_reader, client_writer, args, upstream):
+    host, port = upstream
+    try:
+        server_reader, server_writer = await asyncio.open_connection(host, port)
+    except OSError:
+        client_writer.close()
+        return
+
+    mode, after, trickle = args.mode, args.after, args.trickle
+    if mode == "mix":
+        mode = random.choice(MODES)
+        after = random.randint(0, after)
+        trickle = random.uniform(0, trickle)
+    latency = args.latency / 1000
+    print("Connection from %s:%d: %s, after %d bytes, trickle %.1f ms" %
+          (client_writer.get_extra_info("peername")[:2] + (mode, after, trickle)), flush=True)
+
+    tasks = [
+        asyncio.ensure_future(forward(client_reader, server_writer, latency)),
+        asyncio.ensure_future(forward(server_reader, client_writer, latency, mode, after, trickle / 1000)),
+    ]
+
+    # When either side goes away abruptly, so does the other
+    done, pending = await asyncio.wait(tasks, return_when=asyncio.FIRST_EXCEPTION)
+    for task in pending:
+        task.cancel()
+    for task in done:
+        if not task.cancelled():
+            task.exception()
+    client_writer.close()
+    server_writer.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="TCP proxy that adds latency and network faults")
+    parser.add_argument("--upstream", required=True, metavar="HOST:PORT", help="server to forward to")
+    parser.add_argument("--port", type=int, default=8081, help="port to listen on")
+    parser.add_argument("--latency", type=float, default=50,
+                        help="one-way delay in milliseconds added in each direction")
+    parser.add_argument("--mode", choices=MODES + ("mix",), default="latency",
+                        help="what happens to the server's responses")
+    parser.add_argument("--after", type=int, default=100,
+                        help="bytes passed on before a stall or reset")
+    parser.add_argument("--trickle", type=float, default=20,
+                        help="milliseconds between bytes when trickling")
+    parser.add_argument("--seed", type=int, help="seed for the choices made by --mode mix")
+    args = parser.parse_args()
+
+    random.seed(args.seed)
+    host, _, port = args.upstream.rpartition(":")
+    upstream = (host, int(port))
+
+    async def serve():
+        server = await asyncio.start_server(
+            lambda reader, writer: handle(reader, writer, args, upstream), port=args.port)
+        print("Forwarding port %d to %s:%d with %g ms each way (%s)" %
+              (args.port, host, upstream[1], args.latency, args.mode), flush=True)
+        async with server:
+            await server.serve_forever()
+
+    try:
+        asyncio.run(serve())
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+# Arms for iSENSE
+# Copyright (C) 2018 Engaging Computing Group
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""
+A local stand-in for the iSENSE API, for trying the device against a server that can answer in
+either JSON or CBOR.
+
+Every GET under /api/v1/projects/<id> returns the same project document. It is sent as CBOR if
+the request's Accept header prefers application/cbor, and as JSON otherwise, with a matching
+Content-Type. dataSetCount goes up on every request so the arms have something to show, but the
+document stays the same size, so it can be requested for as long as needed.
+Connections are kept open (HTTP/1.1), so pipelined requests are answered in order.
+
+To use it, set Config::APIHost to the address of the machine running this script and
+Config::APIPort to the port it listens on.
+
+Usage:
+    python3 stand_in_server.py [--port 8080] [--json-only]
+    python3 stand_in_server.py --write-samples <directory>
+
+--json-only answers everything in JSON, like the real iSENSE API does today.
+--write-samples writes the document as project.json and project.cbor and exits. These are the
+inputs for the decode benchmark in tools/bench.
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+
+# Value of dataSetCount in the first response. It counts up to LAST_COUNT and then starts over,
+# so that it always has the same number of digits
+START_COUNT = 1000
+LAST_COUNT = 9999
+
+# Number of data set IDs listed in each response. Only the most recent ones are listed,
+# so the document stays the same size however many requests have been made
+DATA_SET_ID_COUNT = 100
+FIRST_DATA_SET_ID = 20000
+
+# The project document. Shaped like /api/v1/projects/2156 on the iSENSE API
+def project_document(project_id, data_set_count):
+    return {
+        "id": project_id,
+        "name": "Plinko!",
+        "url": "https://isenseproject.org/projects/%d" % project_id,
+        "path": "/projects/%d" % project_id,
+        "hidden": False,
+        "featured": False,
+        "likeCount": 12,
+        "content": "<p>Drop a chip and record which slot it lands in.</p>",
+        "timeAgoInWords": "about 8 years",
+        "createdAt": "2018-04-12T14:03:27.000Z",
+        "ownerName": "Engaging Computing Group",
+        "ownerUrl": "https://isenseproject.org/users/1",
+        "dataSetCount": data_set_count,
+        "dataSetIDs": list(range(FIRST_DATA_SET_ID + data_set_count - DATA_SET_ID_COUNT,
+                                 FIRST_DATA_SET_ID + data_set_count)),
+        "fieldCount": 3,
+        "fields": [
+            {"id": 9001, "name": "Timestamp", "type": 1, "unit": "", "restrictions": []},
+            {"id": 9002, "name": "Slot", "type": 2, "unit": "", "restrictions": []},
+            {"id": 9003, "name": "Drop height", "type": 2, "unit": "cm", "restrictions": []},
+        ],
+        "formulaFieldCount": 0,
+        "formulaFields": [],
+    }
+
+
+# Encode a value as CBOR (RFC 8949), using definite lengths and the shortest integer forms
+def cbor_encode(value):
+
+    def head(major, argument):
+        if argument < 24:
+            return bytes([major << 5 | argument])
+        for info, fmt in ((24, ">B"), (25, ">H"), (26, ">I"), (27, ">Q")):
+            if argument < 1 << (8 * struct.calcsize(fmt)):
+                return bytes([major << 5 | info]) + struct.pack(fmt, argument)
+        raise ValueError("integer too large for CBOR: %d" % argument)
+
+    # bool is checked first, as it is also an int in Python
+    if value is False:
+        return b"\xf4"
+    if value is True:
+        return b"\xf5"
+    if value is None:
+        return b"\xf6"
+    if isinstance(value, int):
+        return head(0, value) if value >= 0 else head(1, -1 - value)
+    if isinstance(value, float):
+        return b"\xfb" + struct.pack(">d", value)
+    if isinstance(value, str):
+        encoded = value.encode("utf-8")
+        return head(3, len(encoded)) + encoded
+    if isinstance(value, bytes):
+        return head(2, len(value)) + value
+    if isinstance(value, (list, tuple)):
+        return head(4, len(value)) + b"".join(cbor_encode(item) for item in value)
+    if isinstance(value, dict):
+        return head(5, len(value)) + b"".join(
+            cbor_encode(key) + cbor_encode(item) for key, item in value.items())
+    raise TypeError("can not encode %r as CBOR" % type(value))
+
+
+def encode_json(document):
+    return json.dumps(document, separators=(",", ":")).encode("utf-8")
+
+
+# Return the q value the Accept header gives a media type, or 0 if it is not acceptable
+def accept_quality(accept, media_type):
+    best = 0.0
+    best_specificity = -1
+    for entry in accept.split(","):
+        parts = [part.strip() for part in entry.split(";")]
+        media_range = parts[0].lower()
+        quality = 1.0
+        for parameter in parts[1:]:
+            match = re.fullmatch(r"q\s*=\s*([0-9.]+)", parameter, re.IGNORECASE)
+            if match:
+                quality = float(match.group(1))
+
+        # The most specific matching range decides
+        if media_range == media_type:
+            specificity = 2
+        elif media_range == media_type.split("/")[0] + "/*":
+            specificity = 1
+        elif media_range == "*/*":
+            specificity = 0
+        else:
+            continue
+        if specificity > best_specificity:
+            best, best_specificity = quality, specificity
+    return best
+
+
+class StandInHandler(BaseHTTPRequestHandler):
+
+    protocol_version = "HTTP/1.1"
+
+    # The headers and the body are written separately. Without this, the body would wait
+    # for the client to acknowledge the headers, adding the client's delayed ACK time to every response
+    disable_nagle_algorithm = True
+
+    json_only = False
+    count = START_COUNT
+    count_lock = threading.Lock()
+
+    def do_GET(self):
+        match = re.fullmatch(r"/api/v1/projects/(\d+)", self.path)
+        if not match:
+            self.send_body(404, "application/json", b'{"error":"Not Found"}')
+            return
+
+        with StandInHandler.count_lock:
+            data_set_count = StandInHandler.count
+            StandInHandler.count = START_COUNT if data_set_count == LAST_COUNT else data_set_count + 1
+        document = project_document(int(match.group(1)), data_set_count)
+
+        # JSON is the default. CBOR is only sent to clients that ask for it by name,
+        # not to ones that merely accept anything
+        accept = self.headers.get("Accept", "*/*")
+        cbor_quality = 0.0
+        if not self.json_only and "application/cbor" in accept.lower():
+            cbor_quality = accept_quality(accept, "application/cbor")
+        if cbor_quality > 0 and cbor_quality >= accept_quality(accept, "application/json"):
+            self.send_body(200, "application/cbor", cbor_encode(document))
+        else:
+            self.send_body(200, "application/json; charset=utf-8", encode_json(document))
+
+    def send_body(self, status, content_type, body):
+        self.send_response(status)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(len(body)))
+        if self.close_connection:
+            self.send_header("Connection", "close")
+        self.end_headers()
+        self.wfile.write(body)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local stand-in for the iSENSE API")
+    parser.add_argument("--port", type=int, default=8080, help="port to listen on")
+    parser.add_argument("--json-only", action="store_true", help="never answer in CBOR")
+    parser.add_argument("--write-samples", metavar="DIRECTORY",
+                        help="write project.json and project.cbor to DIRECTORY and exit")
+    args = parser.parse_args()
+
+    if args.write_samples:
+        document = project_document(2156, START_COUNT)
+        os.makedirs(args.write_samples, exist_ok=True)
+        for name, body in (("project.json", encode_json(document)),
+                           ("project.cbor", cbor_encode(document))):
+            path = os.path.join(args.write_samples, name)
+            with open(path, "wb") as sample:
+                sample.write(body)
+            print("Wrote %s (%d bytes)" % (path, len(body)))
+        return
+
+    StandInHandler.json_only = args.json_only
+    server = ThreadingHTTPServer(("", args.port), StandInHandler)
+    print("Serving the stand-in API on port %d" % args.port)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()